@@ -0,0 +1,52 @@
+#include "cipherTool.h"
+#include "cipher.h"
+#include "mappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+size_t trimNewline(const char* text, size_t n)
+{
+    if (n > 0 && text[n - 1] == '\n') {
+        n--;
+        if (n > 0 && text[n - 1] == '\r') {
+            n--;
+        }
+    }
+    return n;
+}
+
+size_t processFile(const std::string& cipher, bool encrypt, const std::string& key,
+                   const std::string& input, const std::string& output)
+{
+    anyCipher engine = makeCipher(cipher, key);
+    mappedInput in(input);
+    if (in.sameFile(output)) {
+        throw std::invalid_argument("Input and output are the same file");
+    }
+    const char* text = in.data();
+    size_t n = trimNewline(in.data(), in.size());
+
+    // Маршрутная перестановка сжимает открытый текст с пробелами в память
+    // процесса; для файла сжатие идёт заранее во временный файл рядом с output,
+    // чтобы память оставалась страницами page cache. Текст из одних пробелов
+    // передаётся как есть - ради той же ошибки, что и у шифра.
+    std::optional<mappedOutput> compacted;
+    if (cipher == "route" && encrypt && n > 0 && std::memchr(text, ' ', n)) {
+        size_t letters = n - std::count(text, text + n, ' ');
+        if (letters > 0) {
+            compacted.emplace(output, letters);
+            std::remove_copy(text, text + n, compacted->data(), ' ');
+            text = compacted->data();
+            n = letters;
+        }
+    }
+
+    mappedOutput out(output, in.size());
+    size_t used = engine.apply(encrypt ? cipherDirection::encrypt : cipherDirection::decrypt,
+                               text, n, out.data(), out.capacity());
+    out.commit(used);
+    return used;
+}
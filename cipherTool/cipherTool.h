@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Длина без завершающего перевода строки ("\n" или "\r\n")
+size_t trimNewline(const char* text, size_t n);
+
+// Шифрует файл input в output шифром cipher ("gronsfeld" или "route", см.
+// makeCipher) через отображение в память, без промежуточных std::string.
+// Результат пишется во временный файл рядом с output (размером со вход) и
+// заменяет output только при успехе; input и output не могут быть одним файлом.
+// Открытый текст маршрутной перестановки с пробелами сначала сжимается во
+// второй временный файл там же - нужно место на диске ещё на длину текста.
+// Возвращает длину результата.
+size_t processFile(const std::string& cipher, bool encrypt, const std::string& key,
+                   const std::string& input, const std::string& output);
@@ -0,0 +1,151 @@
+// cipherTool_test.cpp - Тесты шифрования файлов через отображение в память
+#include "cipherTool.h"
+#include "cipherError.h"
+#include "mappedFile.h"
+#include <UnitTest++/UnitTest++.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <glob.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Временные файлы в /tmp, удаляются после теста
+struct TempFiles {
+    std::string input, output, restored;
+    TempFiles()
+    {
+        std::string base = "/tmp/cipherTool_test_" + std::to_string(::getpid());
+        input = base + ".in";
+        output = base + ".out";
+        restored = base + ".dec";
+    }
+    ~TempFiles()
+    {
+        std::remove(input.c_str());
+        std::remove(output.c_str());
+        std::remove(restored.c_str());
+    }
+    static void write(const std::string& path, const std::string& content)
+    {
+        std::ofstream(path, std::ios::binary) << content;
+    }
+    // Число оставшихся временных файлов вида output.XXXXXX
+    size_t leftovers() const
+    {
+        glob_t found;
+        size_t count = ::glob((output + ".*").c_str(), 0, nullptr, &found) == 0 ? found.gl_pathc : 0;
+        ::globfree(&found);
+        return count;
+    }
+    static std::string read(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+};
+
+SUITE(MappedFileTest)
+{
+    TEST_FIXTURE(TempFiles, OutputIsTruncatedToResult) {
+        {
+            mappedOutput out(output, 10);
+            CHECK_EQUAL(10u, out.capacity());
+            out.data()[0] = 'A';
+            out.data()[1] = 'B';
+            out.commit(2);
+        }
+        CHECK_EQUAL("AB", read(output));
+    }
+
+    TEST_FIXTURE(TempFiles, EmptyInput) {
+        write(input, "");
+        mappedInput in(input);
+        CHECK_EQUAL(0u, in.size());
+    }
+
+    TEST_FIXTURE(TempFiles, OutputKeepsExistingMode) {
+        write(output, "previous");
+        ::chmod(output.c_str(), 0600);
+        mappedOutput(output, 1).commit(0);
+        struct stat st;
+        CHECK_EQUAL(0, ::stat(output.c_str(), &st));
+        CHECK_EQUAL(0600u, st.st_mode & 07777u);
+    }
+
+    TEST_FIXTURE(TempFiles, NewOutputFollowsUmask) {
+        mode_t mask = ::umask(027);
+        mappedOutput(output, 1).commit(0);
+        ::umask(mask);
+        struct stat st;
+        CHECK_EQUAL(0, ::stat(output.c_str(), &st));
+        CHECK_EQUAL(0640u, st.st_mode & 07777u);
+    }
+
+    TEST(MissingInput) {
+        CHECK_THROW(mappedInput("/nonexistent/cipherTool"), std::system_error);
+    }
+
+    TEST(TrimNewline) {
+        CHECK_EQUAL(3u, trimNewline("ABC\n", 4));
+        CHECK_EQUAL(3u, trimNewline("ABC\r\n", 5));
+        CHECK_EQUAL(4u, trimNewline("ABC\n\n", 5));
+        CHECK_EQUAL(0u, trimNewline("\n", 1));
+    }
+}
+
+SUITE(ProcessFileTest)
+{
+    TEST_FIXTURE(TempFiles, RouteRoundTrip) {
+        write(input, "Hello World\n");
+        CHECK_EQUAL(10u, processFile("route", true, "3", input, output));
+        CHECK_EQUAL("LWLEORHLOD", read(output));
+        CHECK_EQUAL(10u, processFile("route", false, "3", output, restored));
+        CHECK_EQUAL("HELLOWORLD", read(restored));
+        CHECK_EQUAL(0u, leftovers());
+    }
+
+    TEST_FIXTURE(TempFiles, SameFileRejected) {
+        write(input, "Hello World\n");
+        CHECK_THROW(processFile("route", true, "3", input, input), std::invalid_argument);
+        CHECK_EQUAL("Hello World\n", read(input));
+    }
+
+    TEST_FIXTURE(TempFiles, FailureKeepsPreviousOutput) {
+        write(output, "previous");
+        write(input, "ABC1DEF\n");
+        CHECK_THROW(processFile("route", true, "3", input, output), std::invalid_argument);
+        write(input, "ABC DEF 1\n");
+        CHECK_THROW(processFile("route", true, "3", input, output), std::invalid_argument);
+        CHECK_EQUAL("previous", read(output));
+        CHECK_EQUAL(0u, leftovers());
+    }
+
+    TEST_FIXTURE(TempFiles, ModAlphaRoundTrip) {
+        write(input, "Привет, мир!\n");
+        size_t encrypted = processFile("gronsfeld", true, "КЛЮЧ", input, output);
+        CHECK_EQUAL(18u, encrypted);
+        processFile("gronsfeld", false, "КЛЮЧ", output, restored);
+        CHECK_EQUAL("ПРИВЕТМИР", read(restored));
+    }
+
+    TEST_FIXTURE(TempFiles, InvalidInput) {
+        write(input, "ABC1\n");
+        CHECK_THROW(processFile("route", true, "3", input, output), std::invalid_argument);
+        CHECK_THROW(processFile("route", true, "3x", input, output), std::invalid_argument);
+        write(input, "");
+        CHECK_THROW(processFile("route", true, "3", input, output), cipher_error);
+        CHECK_THROW(processFile("gronsfeld", true, "КЛЮЧ", input, output), std::invalid_argument);
+        CHECK_THROW(processFile("vigenere", true, "КЛЮЧ", input, output), cipher_error);
+    }
+}
+
+int main()
+{
+    return UnitTest::RunAllTests();
+}
@@ -0,0 +1,41 @@
+// main.cpp - Шифрование файлов: cipherTool <gronsfeld|route> <encrypt|decrypt> <key> <input> <output>
+#include "cipherTool.h"
+
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+static int usage()
+{
+    std::cerr << "Usage: cipherTool <gronsfeld|route> <encrypt|decrypt> <key> <input> <output>\n"
+              << "  gronsfeld - key and text in UTF-8 (Russian alphabet)\n"
+              << "  route     - key is the number of columns, text is ASCII\n"
+              << "The result goes to a temporary file next to <output> and replaces it only\n"
+              << "on success; <input> and <output> must differ. route encrypt of text with\n"
+              << "spaces first compacts it into another temporary file there, so it needs\n"
+              << "free disk space of up to twice the input size.\n";
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 6) {
+        return usage();
+    }
+    bool encrypt;
+    if (std::strcmp(argv[2], "encrypt") == 0) {
+        encrypt = true;
+    } else if (std::strcmp(argv[2], "decrypt") == 0) {
+        encrypt = false;
+    } else {
+        return usage();
+    }
+
+    try {
+        processFile(argv[1], encrypt, argv[3], argv[4], argv[5]);
+    } catch (const std::exception& e) {
+        std::cerr << "cipherTool: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "mappedFile.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::system_error ioError(const std::string& what)
+{
+    return std::system_error(errno, std::generic_category(), what);
+}
+
+mappedInput::mappedInput(const std::string& path) : fd(-1), begin(nullptr), length(0)
+{
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw ioError("Cannot open " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) < 0) {
+        std::system_error error = ioError("Cannot stat " + path);
+        ::close(fd);
+        throw error;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length == 0) {
+        return;
+    }
+    void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        std::system_error error = ioError("Cannot map " + path);
+        ::close(fd);
+        throw error;
+    }
+    ::madvise(p, length, MADV_SEQUENTIAL);
+    begin = static_cast<const char*>(p);
+}
+
+mappedInput::~mappedInput()
+{
+    if (begin) {
+        ::munmap(const_cast<char*>(begin), length);
+    }
+    ::close(fd);
+}
+
+bool mappedInput::sameFile(const std::string& path) const
+{
+    struct stat mine, other;
+    return ::fstat(fd, &mine) == 0 && ::stat(path.c_str(), &other) == 0 &&
+           mine.st_dev == other.st_dev && mine.st_ino == other.st_ino;
+}
+
+mappedOutput::mappedOutput(const std::string& path, size_t capacity) :
+    fd(-1), begin(nullptr), length(capacity), target(path), temporary(path + ".XXXXXX"), committed(false)
+{
+    // Права результата: как у заменяемого файла, иначе - как у нового (0666 с учётом umask);
+    // mkstemp создаёт файл с правами 0600
+    struct stat existing;
+    mode_t mode;
+    if (::stat(path.c_str(), &existing) == 0) {
+        mode = existing.st_mode & 07777;
+    } else {
+        mode_t mask = ::umask(0);
+        ::umask(mask);
+        mode = 0666 & ~mask;
+    }
+    fd = ::mkstemp(&temporary[0]);
+    if (fd < 0) {
+        throw ioError("Cannot create " + path);
+    }
+    if (::fchmod(fd, mode) < 0) {
+        std::system_error error = ioError("Cannot set permissions of " + path);
+        release();
+        throw error;
+    }
+    if (length == 0) {
+        return;
+    }
+    void* p = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(length)) == 0) {
+        p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        std::system_error error = ioError("Cannot map " + path);
+        release();
+        throw error;
+    }
+    ::madvise(p, length, MADV_SEQUENTIAL);
+    begin = static_cast<char*>(p);
+}
+
+mappedOutput::~mappedOutput()
+{
+    release();
+}
+
+void mappedOutput::release()
+{
+    if (begin) {
+        ::munmap(begin, length);
+        begin = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    if (!committed) {
+        ::unlink(temporary.c_str());
+    }
+}
+
+// Отображение снимается до ftruncate: страницы за новым концом файла
+// не должны оставаться доступными
+void mappedOutput::commit(size_t used)
+{
+    if (begin) {
+        ::munmap(begin, length);
+        begin = nullptr;
+    }
+    if (::ftruncate(fd, static_cast<off_t>(used)) < 0) {
+        throw ioError("Cannot truncate output");
+    }
+    length = used;
+    if (::rename(temporary.c_str(), target.c_str()) < 0) {
+        throw ioError("Cannot rename output to " + target);
+    }
+    committed = true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Входной файл, отображённый в память только для чтения с madvise(SEQUENTIAL):
+// страницы подкачиваются по мере прохода и вытесняются как обычный page cache,
+// поэтому RSS процесса не растёт вместе с размером файла
+class mappedInput
+{
+private:
+    int fd;
+    const char* begin;
+    size_t length;
+
+public:
+    explicit mappedInput(const std::string& path);
+    mappedInput(const mappedInput&) = delete;
+    mappedInput& operator=(const mappedInput&) = delete;
+    ~mappedInput();
+
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+    // Тот же ли это файл, что path (по st_dev и st_ino; false, если path нет)
+    bool sameFile(const std::string& path) const;
+};
+
+// Выходной файл заранее заданного размера (верхняя граница результата),
+// отображённый на запись. Данные пишутся во временный файл рядом с path;
+// commit обрезает его до фактической длины и переименовывает в path, так что
+// прежний path заменяется только целиком и только при успехе. Без commit
+// временный файл удаляется в деструкторе.
+class mappedOutput
+{
+private:
+    int fd;
+    char* begin;
+    size_t length;
+    std::string target;
+    std::string temporary;
+    bool committed;
+
+    void release();
+
+public:
+    mappedOutput(const std::string& path, size_t capacity);
+    mappedOutput(const mappedOutput&) = delete;
+    mappedOutput& operator=(const mappedOutput&) = delete;
+    ~mappedOutput();
+
+    char* data() { return begin; }
+    size_t capacity() const { return length; }
+    void commit(size_t used);
+};
@@ -0,0 +1,33 @@
+#pragma once
+// allocationCounter.h - Счётчик выделений памяти для тестов без аллокаций и
+// замеров (perfSuite.h): заменяет глобальные operator new/delete программы.
+//
+// Замена operator new должна быть в программе одна, поэтому заголовок
+// подключается только в файле с main теста или замера.
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+inline size_t allocations = 0;
+inline size_t allocatedBytes = 0;
+
+// noinline: иначе вызовы могут встроиться и обойти счётчик
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    allocations++;
+    allocatedBytes += size;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
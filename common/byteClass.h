@@ -0,0 +1,40 @@
+#pragma once
+// byteClass.h - Классы байтов блока из 16 символов для проверки и подсчёта
+// букв: SSE2, если доступно, иначе поэлементно.
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Маска байтов блока из 16 символов: латинские буквы (letters) и пробелы (spaces).
+// Байты старше 0x7F не попадают ни в одну из масок.
+inline void classify(const char* p, unsigned& letters, unsigned& spaces)
+{
+#ifdef __SSE2__
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // (c | 0x20) - 'a' < 26 без беззнакового сравнения: сдвиг диапазона к -128
+    __m128i shifted = _mm_add_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8(0x80 - 'a'));
+    letters = _mm_movemask_epi8(_mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26)));
+    spaces = _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+#else
+    letters = spaces = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        unsigned char lower = static_cast<unsigned char>(p[i]) | 0x20;
+        letters |= static_cast<unsigned>(static_cast<unsigned char>(lower - 'a') < 26) << i;
+        spaces |= static_cast<unsigned>(p[i] == ' ') << i;
+    }
+#endif
+}
+
+// Маска байтов блока старше 0x7F (части многобайтовых символов UTF-8)
+inline unsigned nonAscii(const char* p)
+{
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        mask |= static_cast<unsigned>(static_cast<unsigned char>(p[i]) >= 0x80) << i;
+    }
+    return mask;
+#endif
+}
@@ -0,0 +1,46 @@
+#include "cipher.h"
+#include "modAlphaCipher.h"
+#include "routeCipher.h"
+
+static int routeKey(const std::string& key)
+{
+    size_t used = 0;
+    int k = 0;
+    try {
+        k = std::stoi(key, &used);
+    } catch (const std::exception&) {
+        used = 0;
+    }
+    if (used == 0 || used != key.size()) {
+        throw cipher_error("Invalid key: " + key);
+    }
+    return k;
+}
+
+// Ключ из UTF-8 тем же декодером, что и текст шифра Гронсфельда
+static std::wstring wideKey(const std::string& key)
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(key.data());
+    const unsigned char* end = p + key.size();
+    std::wstring wide;
+    while (p < end) {
+        size_t length = *p < 0x80 ? 1 : utf8Length(p, end);
+        if (length == 0) {
+            throw cipher_error("Invalid key: not UTF-8");
+        }
+        wide.push_back(utf8Decode(p, length));
+        p += length;
+    }
+    return wide;
+}
+
+anyCipher makeCipher(const std::string& name, const std::string& key)
+{
+    if (name == "gronsfeld") {
+        return anyCipher(modAlphaCipher(wideKey(key)));
+    }
+    if (name == "route") {
+        return anyCipher(routeCipher(routeKey(key)));
+    }
+    throw cipher_error("Unknown cipher: " + name);
+}
@@ -0,0 +1,88 @@
+#pragma once
+// cipher.h - Общий интерфейс шифров библиотеки.
+//
+// Понятие шифра: тип T с методами
+//     size_t encrypt(const char* in, size_t n, char* out, size_t capacity)
+//     size_t decrypt(const char* in, size_t n, char* out, size_t capacity)
+// над байтами (UTF-8 для modAlphaCipher, ASCII для routeCipher); результат
+// пишется в out и не длиннее входа, ошибки входа - cipher_error.
+//
+// Два способа вызова:
+//  - статический: T наследует cipherBase<T>, обобщённый код принимает
+//    cipherBase<T>& и вызывает apply - вызов разрешается при компиляции и
+//    встраивается, как прямой вызов T;
+//  - динамический: anyCipher хранит любой такой T за виртуальным интерфейсом,
+//    makeCipher строит его по имени и ключу из конфигурации.
+#include "cipherError.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+enum class cipherDirection { encrypt, decrypt };
+
+template <typename Derived>
+class cipherBase
+{
+public:
+    size_t apply(cipherDirection direction, const char* in, size_t n, char* out, size_t capacity)
+    {
+        Derived& self = static_cast<Derived&>(*this);
+        if (direction == cipherDirection::encrypt) {
+            return self.encrypt(in, n, out, capacity);
+        }
+        return self.decrypt(in, n, out, capacity);
+    }
+
+    std::string apply(cipherDirection direction, std::string_view text)
+    {
+        std::string result(text.size(), '\0');
+        result.resize(apply(direction, text.data(), text.size(), &result[0], result.size()));
+        return result;
+    }
+
+protected:
+    ~cipherBase() = default;
+};
+
+class anyCipher
+{
+private:
+    struct holder {
+        virtual ~holder() = default;
+        virtual size_t apply(cipherDirection direction, const char* in, size_t n, char* out, size_t capacity) = 0;
+    };
+
+    template <typename T>
+    struct model : holder {
+        T cipher;
+        explicit model(T c) : cipher(std::move(c)) {}
+        size_t apply(cipherDirection direction, const char* in, size_t n, char* out, size_t capacity) override
+        {
+            return cipher.apply(direction, in, n, out, capacity);
+        }
+    };
+
+    std::unique_ptr<holder> self;
+
+public:
+    template <typename T>
+    explicit anyCipher(T cipher) : self(new model<T>(std::move(cipher))) {}
+
+    size_t apply(cipherDirection direction, const char* in, size_t n, char* out, size_t capacity)
+    {
+        return self->apply(direction, in, n, out, capacity);
+    }
+
+    std::string apply(cipherDirection direction, std::string_view text)
+    {
+        std::string result(text.size(), '\0');
+        result.resize(apply(direction, text.data(), text.size(), &result[0], result.size()));
+        return result;
+    }
+};
+
+// Шифр по имени из конфигурации: "gronsfeld" (ключ - слово в UTF-8)
+// или "route" (ключ - число столбцов). Неизвестное имя или ключ - cipher_error.
+anyCipher makeCipher(const std::string& name, const std::string& key);
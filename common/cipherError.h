@@ -0,0 +1,10 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+
+// Ошибка входных данных (ключа, текста, буфера) любого шифра библиотеки
+class cipher_error : public std::invalid_argument {
+public:
+    explicit cipher_error(const std::string& what_arg) : 
+        std::invalid_argument(what_arg) {}
+};
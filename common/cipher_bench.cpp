@@ -0,0 +1,134 @@
+// cipher_bench.cpp - Цена диспетчеризации: прямой вызов, cipherBase и anyCipher
+#include "cipher.h"
+#include "compositeCipher.h"
+#include "modAlphaCipher.h"
+#include "routeCipher.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Лучший из пяти прогонов: разница путей меньше шума одного замера
+template <typename F>
+double nsPerCall(size_t calls, F f)
+{
+    double best = 0;
+    for (int attempt = 0; attempt < 5; attempt++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        if (attempt == 0 || elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    return best / calls;
+}
+
+// Горячий цикл обобщённого кода над статическим интерфейсом
+template <typename T>
+size_t encryptAll(cipherBase<T>& cipher, const std::vector<std::string>& messages, char* out, size_t capacity)
+{
+    size_t total = 0;
+    for (const auto& m : messages) {
+        total += cipher.apply(cipherDirection::encrypt, m.data(), m.size(), out, capacity);
+    }
+    return total;
+}
+
+template <typename T>
+void compare(const char* name, T cipher, anyCipher erased, const std::vector<std::string>& messages, int rounds)
+{
+    std::string out(1 << 16, '\0');
+    size_t calls = messages.size() * rounds;
+    size_t sink = 0;
+    double direct = nsPerCall(calls, [&] {
+        for (int r = 0; r < rounds; r++) {
+            for (const auto& m : messages) {
+                sink += cipher.encrypt(m.data(), m.size(), &out[0], out.size());
+            }
+        }
+    });
+    double viaBase = nsPerCall(calls, [&] {
+        for (int r = 0; r < rounds; r++) {
+            sink += encryptAll(cipher, messages, &out[0], out.size());
+        }
+    });
+    double viaErased = nsPerCall(calls, [&] {
+        for (int r = 0; r < rounds; r++) {
+            for (const auto& m : messages) {
+                sink += erased.apply(cipherDirection::encrypt, m.data(), m.size(), &out[0], out.size());
+            }
+        }
+    });
+    std::printf("%-22s %10.1f %12.1f %12.1f %9.3f %9.3f\n", name, direct, viaBase, viaErased,
+                viaBase / direct, viaErased / direct);
+    if (sink == 0) {
+        std::printf("empty output\n");
+    }
+}
+
+int main()
+{
+    std::printf("%-22s %10s %12s %12s %9s %9s\n", "ns/call", "direct", "cipherBase", "anyCipher",
+                "base/dir", "any/dir");
+    for (size_t size : { 16, 64, 4096 }) {
+        std::vector<std::string> ascii(1000), russian(1000);
+        for (size_t i = 0; i < ascii.size(); i++) {
+            for (size_t j = 0; j < size; j++) {
+                ascii[i].push_back('A' + (i + j * 7) % 26);
+            }
+            while (russian[i].size() < size) {
+                russian[i] += "съешьжеещё";
+            }
+            russian[i].resize(size);
+        }
+        int rounds = size >= 4096 ? 10 : 200;
+        std::string label = "route, " + std::to_string(size) + " B";
+        compare(label.c_str(), routeCipher(7), makeCipher("route", "7"), ascii, rounds);
+        label = "gronsfeld, " + std::to_string(size) + " B";
+        compare(label.c_str(), modAlphaCipher(L"КЛЮЧ"), makeCipher("gronsfeld", "КЛЮЧ"), russian, rounds);
+    }
+
+    // Гронсфельд (латиница) + перестановка: цепочка из двух шифров против
+    // совмещённого прохода; текст с пробелами и знаками препинания
+    const std::string phrase = "The quick brown fox jumps over the lazy dog, again and again. ";
+    std::printf("\n%-10s %14s %14s %14s %9s\n", "MB/s", "chain string", "chain buffer", "composite", "speedup");
+    for (size_t size : { 4096, 1 << 20, 16 << 20 }) {
+        std::string text;
+        while (text.size() < size) {
+            text += phrase;
+        }
+        text.resize(size);
+        basicModAlphaCipher<latinAlphabet> substitution(L"SECRET");
+        routeCipher transposition(64);
+        compositeCipher composite(L"SECRET", 64);
+        std::string middle(size, '\0'), out(size, '\0');
+        if (composite.encrypt(text) != transposition.encrypt(substitution.encrypt(std::string_view(text)))) {
+            std::printf("composite mismatch\n");
+            return 1;
+        }
+        size_t calls = std::max<size_t>(1, (64u << 20) / size);
+        double chained = nsPerCall(calls, [&] {
+            for (size_t c = 0; c < calls; c++) {
+                transposition.encrypt(substitution.encrypt(std::string_view(text)));
+            }
+        });
+        double buffered = nsPerCall(calls, [&] {
+            for (size_t c = 0; c < calls; c++) {
+                size_t n = substitution.encrypt(std::string_view(text), &middle[0], middle.size());
+                transposition.encrypt(&middle[0], n, &out[0], out.size());
+            }
+        });
+        double fused = nsPerCall(calls, [&] {
+            for (size_t c = 0; c < calls; c++) {
+                composite.encrypt(text.data(), text.size(), &out[0], out.size());
+            }
+        });
+        auto mbs = [&](double ns) { return size / ns * 1e3; };
+        std::string label = std::to_string(size >> 10) + " KB";
+        std::printf("%-10s %14.1f %14.1f %14.1f %8.2fx\n", label.c_str(), mbs(chained), mbs(buffered),
+                    mbs(fused), chained / fused);
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// cipher_test.cpp - Тесты общего интерфейса шифров
+#include "cipher.h"
+#include "compositeCipher.h"
+#include "modAlphaCipher.h"
+#include "routeCipher.h"
+#include "sharedInstance.h"
+#include <UnitTest++/UnitTest++.h>
+#include <string>
+#include <vector>
+
+// Обобщённый код над статическим интерфейсом
+template <typename T>
+std::string roundTrip(cipherBase<T>& cipher, const std::string& text)
+{
+    return cipher.apply(cipherDirection::decrypt, cipher.apply(cipherDirection::encrypt, text));
+}
+
+SUITE(CipherInterfaceTest)
+{
+    TEST(SharedErrorType) {
+        // Одна и та же cipher_error из обоих шифров в одной единице трансляции
+        CHECK_THROW(routeCipher(0), cipher_error);
+        CHECK_THROW(modAlphaCipher(L"А1"), cipher_error);
+    }
+
+    TEST(StaticMatchesDirect) {
+        routeCipher route(3);
+        CHECK_EQUAL(route.encrypt(std::string("Hello World")),
+                    route.apply(cipherDirection::encrypt, "Hello World"));
+        modAlphaCipher gronsfeld(L"КЛЮЧ");
+        CHECK_EQUAL(gronsfeld.encrypt(std::string_view("Привет, мир")),
+                    gronsfeld.apply(cipherDirection::encrypt, "Привет, мир"));
+        CHECK_EQUAL("HELLOWORLD", roundTrip(route, "Hello World"));
+        CHECK_EQUAL("ПРИВЕТМИР", roundTrip(gronsfeld, "Привет, мир"));
+    }
+
+    TEST(TypeErasedMatchesStatic) {
+        routeCipher route(4);
+        modAlphaCipher gronsfeld(L"СЕКРЕТ");
+        std::vector<anyCipher> pipeline;
+        pipeline.push_back(anyCipher(route));
+        pipeline.push_back(makeCipher("gronsfeld", "СЕКРЕТ"));
+        CHECK_EQUAL(route.apply(cipherDirection::encrypt, "ABCDEFGHIJ"),
+                    pipeline[0].apply(cipherDirection::encrypt, "ABCDEFGHIJ"));
+        CHECK_EQUAL(gronsfeld.apply(cipherDirection::encrypt, "Съешь же ещё"),
+                    pipeline[1].apply(cipherDirection::encrypt, "Съешь же ещё"));
+    }
+
+    TEST(BufferTooSmall) {
+        anyCipher route = makeCipher("route", "3");
+        char out[4];
+        CHECK_THROW(route.apply(cipherDirection::encrypt, "ABCDEF", 6, out, sizeof out), cipher_error);
+    }
+
+    TEST(FactoryErrors) {
+        CHECK_THROW(makeCipher("vigenere", "KEY"), cipher_error);
+        CHECK_THROW(makeCipher("route", "3x"), cipher_error);
+        CHECK_THROW(makeCipher("route", ""), cipher_error);
+        CHECK_THROW(makeCipher("route", "0"), cipher_error);
+        CHECK_THROW(makeCipher("gronsfeld", "ААА"), cipher_error);
+        CHECK_THROW(makeCipher("gronsfeld", "\xff"), cipher_error);
+        CHECK_THROW(makeCipher("gronsfeld", "\xd0"), cipher_error);
+        CHECK_THROW(makeCipher("gronsfeld", "\xc0\x80"), cipher_error);
+    }
+}
+
+SUITE(CompositeTest)
+{
+    // Эталон - две отдельные операции
+    std::string chain(const std::wstring& key, int columns, const std::string& text)
+    {
+        basicModAlphaCipher<latinAlphabet> substitution(key);
+        return routeCipher(columns).encrypt(substitution.encrypt(std::string_view(text)));
+    }
+
+    TEST(MatchesTwoStepChain) {
+        std::string text;
+        for (int i = 0; i < 3000; i++) {
+            text.push_back(i % 11 == 0 ? ' ' : i % 17 == 0 ? ',' : static_cast<char>((i % 3 ? 'a' : 'A') + (i * 7) % 26));
+            if (i % 101 == 0) {
+                text += "ё";
+            }
+        }
+        const wchar_t* keys[] = { L"KEY", L"secret", L"AB", L"ZYXWVUTSRQPONMLKJIHGFEDCBA" };
+        int columns[] = { 1, 2, 3, 7, 64, 1000 };
+        size_t lengths[] = { 1, 2, 5, 64, 65, 999, 3000 };
+        for (const wchar_t* key : keys) {
+            for (int k : columns) {
+                compositeCipher cipher(key, k);
+                for (size_t n : lengths) {
+                    std::string part = text.substr(0, n);
+                    if (part.find_first_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz") == std::string::npos) {
+                        continue;
+                    }
+                    std::string expected = chain(key, k, part);
+                    CHECK_EQUAL(expected, cipher.encrypt(part));
+                    basicModAlphaCipher<latinAlphabet> substitution(key);
+                    CHECK_EQUAL(substitution.decrypt(std::string_view(routeCipher(k).decrypt(expected))),
+                                cipher.decrypt(expected));
+                }
+            }
+        }
+    }
+
+    TEST(HugeKeyAllocatesByText) {
+        // Столбцов не больше, чем букв: ключ в миллиарды колонок памяти не требует
+        compositeCipher cipher(L"KEY", 2000000000);
+        std::string expected = chain(L"KEY", 2000000000, "Hello, world");
+        CHECK_EQUAL(expected, cipher.encrypt("Hello, world"));
+        CHECK_EQUAL("HELLOWORLD", cipher.decrypt(expected));
+    }
+
+    TEST(LowercaseCipherText) {
+        compositeCipher cipher(L"KEY", 4);
+        std::string encrypted = cipher.encrypt("Attack at dawn");
+        std::string lower = encrypted;
+        for (auto& c : lower) {
+            c |= 0x20;
+        }
+        CHECK_EQUAL("ATTACKATDAWN", cipher.decrypt(lower));
+    }
+
+    TEST(SharedInstance) {
+        // Один экземпляр из нескольких потоков: длины текстов разные, поэтому
+        // разные и начала столбцов
+        const compositeCipher cipher(L"secret", 7);
+        std::vector<std::string> texts, expected;
+        for (int t = 0; t < 4; t++) {
+            std::string text;
+            for (int i = 0; i < 1000 * (t + 1) + t; i++) {
+                text.push_back(i % 6 ? static_cast<char>('a' + (i * (t + 5)) % 26) : ' ');
+            }
+            texts.push_back(text);
+            expected.push_back(chain(L"secret", 7, text));
+        }
+        CHECK_EQUAL(0u, sharedInstanceMismatches(texts.size(), 50, [&](size_t t) {
+            std::string out(texts[t].size(), '\0');
+            size_t length = cipher.encrypt(texts[t].data(), texts[t].size(), &out[0], out.size());
+            return out.compare(0, length, expected[t]) == 0;
+        }));
+    }
+
+    TEST(CompositeErrors) {
+        CHECK_THROW(compositeCipher(L"", 3), cipher_error);
+        CHECK_THROW(compositeCipher(L"AAA", 3), cipher_error);
+        CHECK_THROW(compositeCipher(L"KEY", 0), cipher_error);
+        compositeCipher cipher(L"KEY", 3);
+        CHECK_THROW(cipher.encrypt("123 !"), cipher_error);
+        CHECK_THROW(cipher.encrypt("AB\xff"), cipher_error);
+        CHECK_THROW(cipher.decrypt(""), cipher_error);
+        CHECK_THROW(cipher.decrypt("AB C"), cipher_error);
+        char out[2];
+        CHECK_THROW(cipher.apply(cipherDirection::encrypt, "ABC", 3, out, sizeof out), cipher_error);
+    }
+}
+
+int main()
+{
+    return UnitTest::RunAllTests();
+}
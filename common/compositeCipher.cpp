@@ -0,0 +1,177 @@
+#include "compositeCipher.h"
+#include "byteClass.h"
+#include <algorithm>
+
+compositeCipher::compositeCipher(const std::wstring& substitution_key, int transposition_key) :
+    transposition(transposition_key)
+{
+    using table = alphabetTable<latinAlphabet>;
+    // Проверка ключа - та же, что у шифра Гронсфельда
+    basicModAlphaCipher<latinAlphabet> substitution(substitution_key);
+    keyLength = substitution_key.size();
+    encryptRows.assign(keyLength * span, '\0');
+    decryptRows.assign(keyLength * span, '\0');
+    for (size_t k = 0; k < keyLength; k++) {
+        size_t shift = table::foldedIndexOf(substitution_key[k]);
+        for (size_t c = 0; c < span; c++) {
+            // Перестановка принимает шифротекст в любом регистре, поэтому и
+            // строки расшифрования заполняются для обоих регистров
+            int index = table::foldedIndexOf(static_cast<wchar_t>(c));
+            if (index >= 0) {
+                encryptRows[k * span + c] = static_cast<char>(table::letters[(index + shift) % table::size]);
+                decryptRows[k * span + c] = static_cast<char>(table::letters[(index + table::size - shift) % table::size]);
+            }
+        }
+    }
+}
+
+// Число латинских букв; многобайтовые символы UTF-8 проверяются и пропускаются.
+// Блоки из 16 ASCII-байт считаются по маске classify.
+size_t compositeCipher::countLetters(const char* in, size_t n) const
+{
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(in);
+    const char* row = encryptRows.data();
+    size_t letters = 0, i = 0;
+    while (i < n) {
+        if (i + 16 <= n && nonAscii(in + i) == 0) {
+            unsigned mask, spaces;
+            classify(in + i, mask, spaces);
+            letters += __builtin_popcount(mask);
+            i += 16;
+            continue;
+        }
+        if (s[i] < 0x80) {
+            letters += row[s[i]] != '\0';
+            i++;
+            continue;
+        }
+        size_t length = utf8Length(s + i, s + n);
+        if (length == 0) {
+            throw cipher_error("Invalid UTF-8 sequence");
+        }
+        i += length;
+    }
+    return letters;
+}
+
+namespace {
+
+// Начала столбцов для одного вызова: буфер потока переиспользуется между
+// вызовами, слишком большой освобождается. Столбцов не больше, чем букв,
+// поэтому огромный ключ памяти не требует.
+class columnStarts
+{
+private:
+    static constexpr size_t scratchLimit = 1 << 20;
+    std::vector<size_t>& scratch;
+
+public:
+    const size_t* offsets;
+    size_t columns;
+
+    columnStarts(const routeCipher& transposition, size_t n) : scratch(buffer())
+    {
+        size_t key_size = static_cast<size_t>(transposition.getKey());
+        scratch.resize(std::min(key_size, n));
+        columns = transposition.columnOffsets(n, scratch.data());
+        offsets = scratch.data();
+    }
+
+    ~columnStarts()
+    {
+        if (scratch.capacity() * sizeof(size_t) > scratchLimit) {
+            std::vector<size_t>().swap(scratch);
+        }
+    }
+
+    columnStarts(const columnStarts&) = delete;
+    columnStarts& operator=(const columnStarts&) = delete;
+
+private:
+    static std::vector<size_t>& buffer()
+    {
+        static thread_local std::vector<size_t> starts;
+        return starts;
+    }
+};
+
+}
+
+// Буква номер p стоит в строке p / key, столбце p % key таблицы; её место в
+// шифротексте - начало столбца плюс номер строки. Вход проверен countLetters,
+// поэтому дальше байты UTF-8 старше 0x7F просто пропускаются: буквы блока из 16
+// байт перебираются по маске без ветвления на каждом символе.
+size_t compositeCipher::encrypt(const char* in, size_t n, char* out, size_t capacity) const
+{
+    size_t letters = countLetters(in, n);
+    if (letters == 0) {
+        throw cipher_error("Empty open text");
+    }
+    if (capacity < letters) {
+        throw cipher_error("Output buffer too small");
+    }
+    columnStarts table(transposition, letters);
+    const size_t* offsets = table.offsets;
+
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(in);
+    const char* rows = encryptRows.data();
+    const char* last = rows + (keyLength - 1) * span;
+    const char* row = rows;
+    size_t i = 0, j = 0;
+    auto put = [&](unsigned char c) {
+        out[offsets[j] + i] = row[c];
+        row = row == last ? rows : row + span;
+        if (++j == table.columns) {
+            j = 0;
+            i++;
+        }
+    };
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        unsigned mask, spaces;
+        classify(in + k, mask, spaces);
+        while (mask != 0) {
+            put(s[k + __builtin_ctz(mask)]);
+            mask &= mask - 1;
+        }
+    }
+    for (; k < n; k++) {
+        if (row[s[k]] != '\0') {
+            put(s[k]);
+        }
+    }
+    return letters;
+}
+
+// Обратный порядок: сбор из столбцов шифротекста, замена и последовательная запись
+size_t compositeCipher::decrypt(const char* in, size_t n, char* out, size_t capacity) const
+{
+    // Те же ошибки, что у routeCipher::decrypt
+    switch (routeCipher::validateCipherText(in, n).error) {
+    case routeCipher::emptyText:
+        throw cipher_error("Empty cipher text");
+    case routeCipher::invalidCharacter:
+        throw cipher_error("Cipher text contains invalid characters");
+    default:
+        break;
+    }
+    if (capacity < n) {
+        throw cipher_error("Output buffer too small");
+    }
+    columnStarts table(transposition, n);
+    const size_t* offsets = table.offsets;
+
+    const char* rows = decryptRows.data();
+    const char* last = rows + (keyLength - 1) * span;
+    const char* row = rows;
+    size_t i = 0, j = 0;
+    for (size_t p = 0; p < n; p++) {
+        out[p] = row[static_cast<unsigned char>(in[offsets[j] + i])];
+        row = row == last ? rows : row + span;
+        if (++j == table.columns) {
+            j = 0;
+            i++;
+        }
+    }
+    return n;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "cipher.h"
+#include "modAlphaCipher.h"
+#include "routeCipher.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Шифр Гронсфельда над латиницей, затем маршрутная перестановка routeCipher
+// (маршрут по умолчанию) - за один проход записи: каждая буква заменяется и
+// сразу пишется на своё место в шифротексте, без промежуточного текста.
+// Результат совпадает с цепочкой
+//     routeCipher(k).encrypt(basicModAlphaCipher<latinAlphabet>(key).encrypt(text))
+// включая ошибки входа. Геометрия таблицы зависит от числа букв, поэтому
+// шифрованию предшествует проход только на чтение: проверка UTF-8 и подсчёт букв.
+class compositeCipher : public cipherBase<compositeCipher>
+{
+private:
+    // Строка таблицы на каждый байт: байты UTF-8 старше 0x7F - не буквы
+    static constexpr size_t span = 256;
+
+    size_t keyLength;
+    routeCipher transposition;
+    std::vector<char> encryptRows; // по строке на позицию ключа: байт -> буква шифра, 0 - не буква
+    std::vector<char> decryptRows; // буква шифротекста -> буква открытого текста
+
+    size_t countLetters(const char* in, size_t n) const;
+
+public:
+    compositeCipher() = delete;
+    compositeCipher(const std::wstring& substitution_key, int transposition_key);
+
+    std::string encrypt(std::string_view open_text) { return apply(cipherDirection::encrypt, open_text); }
+    std::string decrypt(std::string_view cipher_text) { return apply(cipherDirection::decrypt, cipher_text); }
+    // Общий интерфейс шифров (cipher.h); результат не длиннее входа. Вызовы не
+    // меняют шифр, один экземпляр можно использовать из нескольких потоков.
+    size_t encrypt(const char* in, size_t n, char* out, size_t capacity) const;
+    size_t decrypt(const char* in, size_t n, char* out, size_t capacity) const;
+};
@@ -0,0 +1,57 @@
+#pragma once
+// parallel.h - Общий параллельный режим шифров: запуск рабочих потоков и
+// выбор их числа по длине текста.
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+// Запускает worker(t) в threads потоках и пробрасывает первое исключение.
+// Если поток создать не удалось, оставшиеся куски выполняет вызывающий поток:
+// уже запущенные потоки всё равно дожидаются, иначе деструктор std::thread
+// вызвал бы std::terminate.
+template <typename Worker>
+void runWorkers(unsigned threads, Worker worker)
+{
+    std::vector<std::exception_ptr> errors(threads);
+    auto run = [&worker, &errors](unsigned t) {
+        try {
+            worker(t);
+        } catch (...) {
+            errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    unsigned started = 0;
+    try {
+        for (; started < threads; started++) {
+            pool.emplace_back(run, started);
+        }
+    } catch (const std::system_error&) {
+    }
+    for (unsigned t = started; t < threads; t++) {
+        run(t);
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    for (auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+// Число потоков для текста длины n: не больше, чем кусков по parallelChunk символов
+inline unsigned workerCount(unsigned threads, size_t n)
+{
+    const size_t parallelChunk = 64 * 1024;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    size_t chunks = (n + parallelChunk - 1) / parallelChunk;
+    return static_cast<unsigned>(std::max<size_t>(1, std::min<size_t>(threads, chunks)));
+}
@@ -0,0 +1,218 @@
+#pragma once
+// perfSuite.h - Общий каркас машинно-читаемых замеров для обоих шифров.
+//
+// Каждый замер - одна операция над сообщением фиксированного размера:
+// вызов повторяется, пока не наберётся minTime секунд (не меньше одного раза),
+// выделения памяти считает глобальный operator new программы замеров.
+// Результат - JSON в духе Google Benchmark, по объекту замера на строку,
+// чтобы его можно было сравнивать построчно.
+//
+// Параметры командной строки:
+//   --max-bytes=N    наибольший размер сообщения (по умолчанию 1 ГБ)
+//   --min-time=S     минимальное время одного замера в секундах (0.2)
+//   --out=FILE       куда писать JSON (по умолчанию stdout)
+//   --baseline=FILE  сравнить MB/s с прежним результатом этой же программы
+//   --tolerance=F    допустимое падение MB/s относительно baseline (0.2 = 20%)
+// При падении больше допустимого программа завершается с кодом 1; при ошибке
+// параметров или baseline, который не открывается или не содержит замеров, - 2.
+// Замеры, которые есть только с одной стороны, перечисляются в stderr.
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct perfResult {
+    std::string name;
+    std::string operation;
+    size_t key;
+    size_t bytes;
+    size_t iterations;
+    double nsPerChar;
+    double mbPerSecond;
+    double allocsPerCall;
+};
+
+class perfSuite
+{
+private:
+    const char* library;
+    const size_t* allocations;
+    size_t maxBytes;
+    double minTime;
+    double tolerance;
+    std::string output;
+    std::string baseline;
+    std::vector<perfResult> results;
+
+    static const char* option(const char* arg, const char* name)
+    {
+        size_t n = std::strlen(name);
+        return std::strncmp(arg, name, n) == 0 ? arg + n : nullptr;
+    }
+
+    // Прежние MB/s по имени замера из JSON, записанного write();
+    // false, если файл не открывается
+    bool readBaseline(std::map<std::string, double>& previous) const
+    {
+        std::ifstream file(baseline.c_str());
+        if (!file) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t name = line.find("\"name\": \"");
+            size_t speed = line.find("\"mb_per_s\": ");
+            if (name == std::string::npos || speed == std::string::npos) {
+                continue;
+            }
+            name += 9;
+            previous[line.substr(name, line.find('"', name) - name)] = std::atof(line.c_str() + speed + 12);
+        }
+        return true;
+    }
+
+public:
+    // allocation_counter - счётчик вызовов operator new программы замеров
+    perfSuite(const char* library_name, const size_t* allocation_counter, int argc, char** argv) :
+        library(library_name), allocations(allocation_counter), maxBytes(size_t(1) << 30),
+        minTime(0.2), tolerance(0.2)
+    {
+        for (int i = 1; i < argc; i++) {
+            if (const char* v = option(argv[i], "--max-bytes=")) {
+                maxBytes = std::strtoull(v, nullptr, 10);
+                if (maxBytes < 16) {
+                    std::cerr << "--max-bytes must be at least 16\n";
+                    std::exit(2);
+                }
+            } else if (const char* v = option(argv[i], "--min-time=")) {
+                minTime = std::atof(v);
+            } else if (const char* v = option(argv[i], "--out=")) {
+                output = v;
+            } else if (const char* v = option(argv[i], "--baseline=")) {
+                baseline = v;
+            } else if (const char* v = option(argv[i], "--tolerance=")) {
+                tolerance = std::atof(v);
+            } else {
+                std::cerr << "unknown option " << argv[i] << "\n";
+                std::exit(2);
+            }
+        }
+    }
+
+    // Размеры сообщений от 16 байт с шагом x16, последний - maxBytes
+    std::vector<size_t> sizes() const
+    {
+        std::vector<size_t> result;
+        for (size_t bytes = 16; bytes < maxBytes; bytes *= 16) {
+            result.push_back(bytes);
+        }
+        result.push_back(maxBytes);
+        return result;
+    }
+
+    // size - размер сообщения в имени замера, bytes и chars - фактический
+    // объём входа операции (для шифротекста и UTF-8 они отличаются от size)
+    template <typename F>
+    void run(const std::string& operation, size_t key, size_t size, size_t bytes, size_t chars, F f)
+    {
+        // Прогрев заполняет внутренние буферы; большие сообщения не прогреваются,
+        // чтобы замер 1 ГБ не удваивался
+        if (bytes < (size_t(16) << 20)) {
+            f();
+        }
+        size_t before = *allocations;
+        size_t iterations = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::chrono::duration<double> elapsed(0);
+        do {
+            f();
+            iterations++;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed.count() < minTime);
+        size_t allocated = *allocations - before;
+
+        perfResult r;
+        r.name = operation + "/key:" + std::to_string(key) + "/bytes:" + std::to_string(size);
+        r.operation = operation;
+        r.key = key;
+        r.bytes = size;
+        r.iterations = iterations;
+        r.nsPerChar = elapsed.count() * 1e9 / (static_cast<double>(chars) * iterations);
+        r.mbPerSecond = static_cast<double>(bytes) * iterations / elapsed.count() / 1e6;
+        r.allocsPerCall = static_cast<double>(allocated) / iterations;
+        results.push_back(r);
+        std::cerr << r.name << ": " << r.mbPerSecond << " MB/s\n";
+    }
+
+    void write(std::ostream& out) const
+    {
+        char date[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        out << "{\n  \"context\": {\"library\": \"" << library << "\", \"date\": \"" << date
+            << "\", \"num_cpus\": " << std::thread::hardware_concurrency()
+            << ", \"max_bytes\": " << maxBytes << ", \"min_time\": " << minTime << "},\n"
+            << "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const perfResult& r = results[i];
+            char line[512];
+            std::snprintf(line, sizeof line,
+                          "    {\"name\": \"%s\", \"operation\": \"%s\", \"key\": %zu, \"bytes\": %zu, "
+                          "\"iterations\": %zu, \"ns_per_char\": %.4f, \"mb_per_s\": %.2f, "
+                          "\"allocs_per_call\": %.2f}%s\n",
+                          r.name.c_str(), r.operation.c_str(), r.key, r.bytes, r.iterations,
+                          r.nsPerChar, r.mbPerSecond, r.allocsPerCall, i + 1 < results.size() ? "," : "");
+            out << line;
+        }
+        out << "  ]\n}\n";
+    }
+
+    // Запись результата и сравнение с baseline; код завершения программы
+    int finish() const
+    {
+        if (output.empty()) {
+            write(std::cout);
+        } else {
+            std::ofstream file(output.c_str());
+            write(file);
+        }
+        if (baseline.empty()) {
+            return 0;
+        }
+        std::map<std::string, double> previous;
+        if (!readBaseline(previous)) {
+            std::cerr << "cannot open baseline " << baseline << "\n";
+            return 2;
+        }
+        if (previous.empty()) {
+            std::cerr << "no benchmarks in baseline " << baseline << "\n";
+            return 2;
+        }
+        int regressions = 0;
+        for (const perfResult& r : results) {
+            auto found = previous.find(r.name);
+            if (found == previous.end()) {
+                std::cerr << "not in baseline: " << r.name << "\n";
+                continue;
+            }
+            if (r.mbPerSecond < found->second * (1 - tolerance)) {
+                std::cerr << "regression " << r.name << ": " << found->second << " -> "
+                          << r.mbPerSecond << " MB/s\n";
+                regressions++;
+            }
+            previous.erase(found);
+        }
+        for (const auto& missing : previous) {
+            std::cerr << "not measured: " << missing.first << "\n";
+        }
+        return regressions ? 1 : 0;
+    }
+};
@@ -0,0 +1,30 @@
+#pragma once
+// sharedInstance.h - Проверка для тестов: один экземпляр шифра из нескольких
+// потоков одновременно.
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// threads потоков по rounds раз вызывают check(t) - true, если результат потока t
+// совпал с ожидаемым; возвращает число несовпадений
+template <typename Check>
+size_t sharedInstanceMismatches(size_t threads, int rounds, Check check)
+{
+    std::vector<size_t> mismatches(threads, 0);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] {
+            for (int r = 0; r < rounds; r++) {
+                mismatches[t] += !check(t);
+            }
+        });
+    }
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    size_t total = 0;
+    for (size_t count : mismatches) {
+        total += count;
+    }
+    return total;
+}
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <string_view>
+
+// Алфавиты для basicModAlphaCipher: буквы в порядке номеров и строчная
+// пара заглавной буквы (по таблице Unicode, без обращения к локали)
+struct russianAlphabet {
+    static constexpr std::wstring_view letters = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+
+    // А..Я (U+0410..U+042F) +0x20, Ѐ..Џ (U+0400..U+040F, в том числе Ё) +0x50
+    static constexpr wchar_t lower(wchar_t c) {
+        return c >= 0x410 && c <= 0x42F ? c + 0x20 : c >= 0x400 && c <= 0x40F ? c + 0x50 : c;
+    }
+};
+
+struct latinAlphabet {
+    static constexpr std::wstring_view letters = L"ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+    static constexpr wchar_t lower(wchar_t c) {
+        return c + (L'a' - L'A');
+    }
+};
+
+struct digitAlphabet {
+    static constexpr std::wstring_view letters = L"0123456789";
+
+    static constexpr wchar_t lower(wchar_t c) {
+        return c;
+    }
+};
+
+// Таблицы алфавита, вычисляемые при компиляции: индекс заглавной буквы,
+// индекс буквы в любом регистре (-1 - символ вне алфавита) и UTF-8 букв
+template <typename Alphabet>
+struct alphabetTable {
+    static constexpr std::wstring_view letters = Alphabet::letters;
+    static constexpr size_t size = letters.size();
+    static_assert(size >= 2 && size <= 128, "alphabet size must fit the byte shift kernel");
+
+    static constexpr wchar_t code(size_t i, bool folded) {
+        return folded ? Alphabet::lower(letters[i]) : letters[i];
+    }
+
+    static constexpr wchar_t lowest(bool folded) {
+        wchar_t result = letters[0];
+        for (size_t i = 0; i < size; i++) {
+            result = std::min({ result, letters[i], code(i, folded) });
+        }
+        return result;
+    }
+
+    static constexpr wchar_t highest(bool folded) {
+        wchar_t result = letters[0];
+        for (size_t i = 0; i < size; i++) {
+            result = std::max({ result, letters[i], code(i, folded) });
+        }
+        return result;
+    }
+
+    static constexpr wchar_t upperBase = lowest(false);
+    static constexpr wchar_t foldBase = lowest(true);
+    static constexpr size_t upperSpan = highest(false) - upperBase + 1;
+    static constexpr size_t foldSpan = highest(true) - foldBase + 1;
+
+    template <size_t Span>
+    static constexpr std::array<signed char, Span> build(wchar_t base, bool folded) {
+        std::array<signed char, Span> table{};
+        for (size_t i = 0; i < Span; i++) {
+            table[i] = -1;
+        }
+        for (size_t i = 0; i < size; i++) {
+            table[letters[i] - base] = static_cast<signed char>(i);
+            table[code(i, folded) - base] = static_cast<signed char>(i);
+        }
+        return table;
+    }
+
+    static constexpr std::array<signed char, upperSpan> upper = build<upperSpan>(upperBase, false);
+    static constexpr std::array<signed char, foldSpan> fold = build<foldSpan>(foldBase, true);
+
+    static constexpr int indexOf(wchar_t c) {
+        size_t offset = static_cast<size_t>(c - upperBase);
+        return offset < upperSpan ? upper[offset] : -1;
+    }
+
+    static constexpr int foldedIndexOf(wchar_t c) {
+        size_t offset = static_cast<size_t>(c - foldBase);
+        return offset < foldSpan ? fold[offset] : -1;
+    }
+
+    // Все буквы обоих регистров должны кодироваться в UTF-8 одинаковой длиной:
+    // тогда шифротекст в UTF-8 никогда не длиннее открытого текста
+    static constexpr size_t utf8Width(wchar_t c) {
+        return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+    }
+
+    static constexpr size_t width = utf8Width(letters[0]);
+
+    static constexpr bool uniformWidth() {
+        for (size_t i = 0; i < size; i++) {
+            if (utf8Width(code(i, false)) != width || utf8Width(code(i, true)) != width) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(uniformWidth(), "alphabet letters must share one UTF-8 length");
+
+    static constexpr std::array<char, size * width> encodeUtf8() {
+        std::array<char, size * width> result{};
+        for (size_t i = 0; i < size; i++) {
+            unsigned c = letters[i];
+            char* out = &result[i * width];
+            if (width == 1) {
+                out[0] = static_cast<char>(c);
+            } else if (width == 2) {
+                out[0] = static_cast<char>(0xC0 | (c >> 6));
+                out[1] = static_cast<char>(0x80 | (c & 0x3F));
+            } else if (width == 3) {
+                out[0] = static_cast<char>(0xE0 | (c >> 12));
+                out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                out[2] = static_cast<char>(0x80 | (c & 0x3F));
+            } else {
+                out[0] = static_cast<char>(0xF0 | (c >> 18));
+                out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+                out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                out[3] = static_cast<char>(0x80 | (c & 0x3F));
+            }
+        }
+        return result;
+    }
+
+    static constexpr std::array<char, size * width> utf8 = encodeUtf8();
+};
+
+// Длина корректной многобайтовой последовательности UTF-8 (RFC 3629) или 0
+inline size_t utf8Length(const unsigned char* p, const unsigned char* end)
+{
+    unsigned char lead = p[0];
+    unsigned char low = 0x80, high = 0xBF;
+    size_t length;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) {
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            high = 0x9F;
+        }
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) {
+            low = 0x90;
+        } else if (lead == 0xF4) {
+            high = 0x8F;
+        }
+    } else {
+        return 0;
+    }
+    if (static_cast<size_t>(end - p) < length || p[1] < low || p[1] > high) {
+        return 0;
+    }
+    for (size_t i = 2; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+// Код символа по корректной последовательности UTF-8 длины length
+inline wchar_t utf8Decode(const unsigned char* p, size_t length)
+{
+    static const unsigned char leadMask[] = { 0, 0x7F, 0x1F, 0x0F, 0x07 };
+    wchar_t c = p[0] & leadMask[length];
+    for (size_t i = 1; i < length; i++) {
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    return c;
+}
@@ -1,133 +1,697 @@
 #include "modAlphaCipher.h"
-#include <locale>
+#include "shiftKernel.h"
+#include "parallel.h"
 #include <algorithm>
+#include <exception>
 #include <iostream>
+#include <thread>
 
-modAlphaCipher::modAlphaCipher(const std::wstring& skey)
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+template <typename Alphabet>
+basicModAlphaCipher<Alphabet>::basicModAlphaCipher(const std::wstring& skey)
 {
-    for (unsigned i = 0; i < numAlpha.size(); i++) {
-        alphaNum[numAlpha[i]] = i;
-    }
     key = convert(getValidKey(skey));
+
+    // Расшифрование - тот же сдвиг на (N - k) mod N
+    std::vector<uint8_t> inverse(key.size());
+    for (size_t i = 0; i < key.size(); i++) {
+        inverse[i] = (table::size - key[i]) % table::size;
+    }
+    encryptStream = makeKeyStream(key);
+    decryptStream = makeKeyStream(inverse);
 }
 
-std::wstring modAlphaCipher::encrypt(const std::wstring& open_text)
+// Индексы шифротекста в block[0, n) без ветвления на символ: у недопустимого
+// символа индекс -1 (в block - 0xFF). Возвращает позицию первого такого или n.
+template <typename Table>
+static size_t upperIndices(const wchar_t* in, size_t n, uint8_t* block)
 {
-    std::vector<int> work;
-    std::wstring upperText = getValidOpenText(open_text);
-    for (auto c : upperText) {
-        work.push_back(alphaNum[c]);
+    int bad = 0;
+    for (size_t j = 0; j < n; j++) {
+        int index = Table::indexOf(in[j]);
+        bad |= index;
+        block[j] = static_cast<uint8_t>(index);
+    }
+    if (bad >= 0) {
+        return n;
     }
-    for(unsigned i = 0; i < work.size(); i++) {
-        work[i] = (work[i] + key[i % key.size()]) % numAlpha.size();
+    return std::find(block, block + n, 0xFF) - block;
+}
+
+// Один проход по тексту: фильтрация и перевод в верхний регистр (для открытого
+// текста) или проверка (для шифротекста), индекс алфавита, сдвиг и запись в out.
+// Индексы копятся в небольшом блоке на стеке, который сдвигается векторным ядром,
+// поэтому каждый символ читается из in и пишется в out ровно один раз.
+// В out должно быть место под n символов; возвращает число записанных.
+// invalid - позиция первого недопустимого символа шифротекста или n; при ошибке
+// записанное в out и phase не определены.
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::scan(const wchar_t* in, size_t n, wchar_t* out,
+                                           const std::vector<uint8_t>& stream, size_t& phase,
+                                           bool openText, size_t& invalid) const noexcept
+{
+    const size_t blockSize = 4096;
+    uint8_t block[blockSize];
+    wchar_t* start = out;
+    size_t i = 0;
+    invalid = n;
+    while (i < n) {
+        size_t count = 0;
+        if (openText) {
+            for (; i < n && count < blockSize; i++) {
+                int index = table::foldedIndexOf(in[i]);
+                if (index >= 0) {
+                    block[count++] = index;
+                }
+            }
+        } else {
+            count = std::min(blockSize, n - i);
+            size_t bad = upperIndices<table>(in + i, count, block);
+            if (bad != count) {
+                invalid = i + bad;
+                break;
+            }
+            i += count;
+        }
+        phase = shiftIndices(block, count, stream.data(), key.size(), phase, table::size);
+        for (size_t j = 0; j < count; j++) {
+            *out++ = table::letters[block[j]];
+        }
     }
-    return convert(work);
+    return out - start;
 }
 
-std::wstring modAlphaCipher::decrypt(const std::wstring& cipher_text)
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::transform(const wchar_t* in, size_t n, wchar_t* out,
+                                 const std::vector<uint8_t>& stream, size_t& phase, bool openText) const
 {
-    std::vector<int> work = convert(getValidCipherText(cipher_text));
-    for(unsigned i = 0; i < work.size(); i++) {
-        work[i] = (work[i] + numAlpha.size() - key[i % key.size()]) % numAlpha.size();
+    size_t invalid;
+    size_t written = scan(in, n, out, stream, phase, openText, invalid);
+    if (invalid != n) {
+        throw cipher_error("Invalid cipher text: must contain only uppercase letters");
     }
-    return convert(work);
+    return written;
 }
 
-std::vector<int> modAlphaCipher::convert(const std::wstring& s)
+template <typename Alphabet>
+modAlphaResult basicModAlphaCipher<Alphabet>::tryEncrypt(const std::wstring& open_text) const noexcept
 {
-    std::vector<int> result;
-    for(auto c : s) {
-        result.push_back(alphaNum[c]);
+    std::wstring value(open_text.size(), L'\0');
+    size_t phase = 0, invalid;
+    value.resize(scan(open_text.data(), open_text.size(), &value[0], encryptStream, phase, true, invalid));
+    if (value.empty()) {
+        return { std::wstring(), modAlphaStatus::emptyText, 0 };
+    }
+    return { std::move(value), modAlphaStatus::ok, 0 };
+}
+
+template <typename Alphabet>
+modAlphaResult basicModAlphaCipher<Alphabet>::tryDecrypt(const std::wstring& cipher_text) const noexcept
+{
+    if (cipher_text.empty()) {
+        return { std::wstring(), modAlphaStatus::emptyText, 0 };
+    }
+    std::wstring value(cipher_text.size(), L'\0');
+    size_t phase = 0, invalid;
+    scan(cipher_text.data(), cipher_text.size(), &value[0], decryptStream, phase, false, invalid);
+    if (invalid != cipher_text.size()) {
+        return { std::wstring(), modAlphaStatus::invalidCharacter, invalid };
+    }
+    return { std::move(value), modAlphaStatus::ok, 0 };
+}
+
+template <typename Alphabet>
+modAlphaValidation basicModAlphaCipher<Alphabet>::validateOpenText(const wchar_t* s, size_t n) noexcept
+{
+    size_t letters = 0;
+    for (size_t i = 0; i < n; i++) {
+        letters += table::foldedIndexOf(s[i]) >= 0;
+    }
+    return { letters ? modAlphaStatus::ok : modAlphaStatus::emptyText, 0 };
+}
+
+template <typename Alphabet>
+modAlphaValidation basicModAlphaCipher<Alphabet>::validateCipherText(const wchar_t* s, size_t n) noexcept
+{
+    if (n == 0) {
+        return { modAlphaStatus::emptyText, 0 };
+    }
+    const size_t blockSize = 256;
+    uint8_t block[blockSize];
+    for (size_t i = 0; i < n; i += blockSize) {
+        size_t count = std::min(blockSize, n - i);
+        size_t bad = upperIndices<table>(s + i, count, block);
+        if (bad != count) {
+            return { modAlphaStatus::invalidCharacter, i + bad };
+        }
+    }
+    return { modAlphaStatus::ok, 0 };
+}
+
+// Ключ: непустой, только буквы алфавита (в любом регистре), не из одной буквы
+template <typename Alphabet>
+modAlphaValidation basicModAlphaCipher<Alphabet>::validateKey(const std::wstring& skey) noexcept
+{
+    if (skey.empty()) {
+        return { modAlphaStatus::emptyKey, 0 };
+    }
+    int first = table::foldedIndexOf(skey[0]);
+    int bad = 0;
+    bool allSame = true;
+    for (auto c : skey) {
+        int index = table::foldedIndexOf(c);
+        bad |= index;
+        allSame &= index == first;
     }
+    if (bad < 0) {
+        for (size_t i = 0; i < skey.size(); i++) {
+            if (table::foldedIndexOf(skey[i]) < 0) {
+                return { modAlphaStatus::invalidCharacter, i };
+            }
+        }
+    }
+    return { allSame ? modAlphaStatus::weakKey : modAlphaStatus::ok, 0 };
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::countLetters(const wchar_t* in, size_t n) const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (table::foldedIndexOf(in[i]) >= 0) {
+            count++;
+        }
+    }
+    return count;
+}
+
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::encrypt(const std::wstring& open_text)
+{
+    std::wstring result(open_text.size(), L'\0');
+    result.resize(encrypt(open_text, &result[0], result.size()));
     return result;
 }
 
-std::wstring modAlphaCipher::convert(const std::vector<int>& v)
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::decrypt(const std::wstring& cipher_text)
 {
-    std::wstring result;
-    for(auto i : v) {
-        result.push_back(numAlpha[i]);
+    std::wstring result(cipher_text.size(), L'\0');
+    decrypt(cipher_text, &result[0], result.size());
+    return result;
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::encrypt(std::wstring_view open_text, wchar_t* out, size_t capacity) const
+{
+    if (capacity < open_text.size()) {
+        throw cipher_error("Output buffer too small");
+    }
+    size_t phase = 0;
+    size_t written = transform(open_text.data(), open_text.size(), out, encryptStream, phase, true);
+    if (written == 0) {
+        throw cipher_error("Empty open text");
+    }
+    return written;
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::decrypt(std::wstring_view cipher_text, wchar_t* out, size_t capacity) const
+{
+    if (cipher_text.empty()) {
+        throw cipher_error("Empty cipher text");
+    }
+    if (capacity < cipher_text.size()) {
+        throw cipher_error("Output buffer too small");
+    }
+    size_t phase = 0;
+    return transform(cipher_text.data(), cipher_text.size(), out, decryptStream, phase, false);
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::encryptInPlace(std::wstring& text) const
+{
+    text.resize(encrypt(text, &text[0], text.size()));
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::decryptInPlace(std::wstring& text) const
+{
+    decrypt(text, &text[0], text.size());
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::encrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const
+{
+    return transform(in, n, out, encryptStream, phase, true);
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::decrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const
+{
+    return transform(in, n, out, decryptStream, phase, false);
+}
+
+// Пропускает ASCII (в алфавит не входит) по 16 байт за раз
+static const unsigned char* skipAscii(const unsigned char* p, const unsigned char* end)
+{
+#ifdef __SSE2__
+    while (end - p >= 16) {
+        int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        if (mask != 0) {
+            return p + __builtin_ctz(mask);
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p < 0x80) {
+        p++;
+    }
+    return p;
+}
+
+// То же, что transform, но над байтами UTF-8: буква декодируется сразу в индекс
+// алфавита, результат пишется в UTF-8 (table::width байт на букву, не длиннее входа)
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::transformUtf8(const char* in, size_t n, char* out,
+                                     const std::vector<uint8_t>& stream, size_t& phase, bool openText) const
+{
+    const size_t blockSize = 4096;
+    uint8_t block[blockSize];
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+    const unsigned char* end = p + n;
+    char* start = out;
+    while (p < end) {
+        size_t count = 0;
+        while (p < end && count < blockSize) {
+            size_t length = 1;
+            if (*p >= 0x80) {
+                length = utf8Length(p, end);
+                if (length == 0) {
+                    throw cipher_error("Invalid UTF-8 sequence");
+                }
+            } else if (table::width > 1 && openText) {
+                // В многобайтовом алфавите ASCII-букв нет
+                p = skipAscii(p, end);
+                continue;
+            }
+            int index = -1;
+            if (length == table::width) {
+                wchar_t c = utf8Decode(p, length);
+                index = openText ? table::foldedIndexOf(c) : table::indexOf(c);
+            }
+            if (index >= 0) {
+                block[count++] = index;
+            } else if (!openText) {
+                throw cipher_error("Invalid cipher text: must contain only uppercase letters");
+            }
+            p += length;
+        }
+        phase = shiftIndices(block, count, stream.data(), key.size(), phase, table::size);
+        for (size_t j = 0; j < count; j++) {
+            const char* letter = &table::utf8[table::width * block[j]];
+            for (size_t k = 0; k < table::width; k++) {
+                *out++ = letter[k];
+            }
+        }
     }
+    return out - start;
+}
+
+template <typename Alphabet>
+std::string basicModAlphaCipher<Alphabet>::encrypt(std::string_view open_text)
+{
+    std::string result(open_text.size(), '\0');
+    result.resize(encrypt(open_text, &result[0], result.size()));
+    return result;
+}
+
+template <typename Alphabet>
+std::string basicModAlphaCipher<Alphabet>::decrypt(std::string_view cipher_text)
+{
+    std::string result(cipher_text.size(), '\0');
+    result.resize(decrypt(cipher_text, &result[0], result.size()));
     return result;
 }
 
-std::wstring modAlphaCipher::toUpperCase(const std::wstring& s)
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::encrypt(std::string_view open_text, char* out, size_t capacity) const
+{
+    if (capacity < open_text.size()) {
+        throw cipher_error("Output buffer too small");
+    }
+    size_t phase = 0;
+    size_t written = transformUtf8(open_text.data(), open_text.size(), out, encryptStream, phase, true);
+    if (written == 0) {
+        throw cipher_error("Empty open text");
+    }
+    return written;
+}
+
+template <typename Alphabet>
+size_t basicModAlphaCipher<Alphabet>::decrypt(std::string_view cipher_text, char* out, size_t capacity) const
+{
+    if (cipher_text.empty()) {
+        throw cipher_error("Empty cipher text");
+    }
+    if (capacity < cipher_text.size()) {
+        throw cipher_error("Output buffer too small");
+    }
+    size_t phase = 0;
+    return transformUtf8(cipher_text.data(), cipher_text.size(), out, decryptStream, phase, false);
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::encryptInPlace(std::string& text) const
+{
+    text.resize(encrypt(text, &text[0], text.size()));
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::decryptInPlace(std::string& text) const
+{
+    text.resize(decrypt(text, &text[0], text.size()));
+}
+
+// Параллельное шифрование в два прохода: потоки считают буквы в своих кусках,
+// по префиксным суммам получают смещение в результате и фазу ключа (смещение
+// по модулю длины ключа), затем независимо пишут в непересекающиеся участки.
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::encrypt(const std::wstring& open_text, unsigned threads)
+{
+    size_t n = open_text.size();
+    unsigned workers = workerCount(threads, n);
+    if (workers == 1) {
+        return encrypt(open_text);
+    }
+
+    const wchar_t* in = open_text.data();
+    size_t part = (n + workers - 1) / workers;
+    std::vector<size_t> offsets(workers + 1, 0);
+    runWorkers(workers, [&](unsigned t) {
+        size_t begin = std::min(n, t * part);
+        size_t end = std::min(n, begin + part);
+        offsets[t + 1] = countLetters(in + begin, end - begin);
+    });
+    for (unsigned t = 0; t < workers; t++) {
+        offsets[t + 1] += offsets[t];
+    }
+    if (offsets[workers] == 0) {
+        throw cipher_error("Empty open text");
+    }
+
+    std::wstring result(offsets[workers], L'\0');
+    wchar_t* out = &result[0];
+    runWorkers(workers, [&](unsigned t) {
+        size_t begin = std::min(n, t * part);
+        size_t end = std::min(n, begin + part);
+        size_t phase = offsets[t] % key.size();
+        transform(in + begin, end - begin, out + offsets[t], encryptStream, phase, true);
+    });
+    return result;
+}
+
+// Шифротекст не фильтруется, поэтому позиция символа в результате совпадает
+// с позицией во входе и хватает одного прохода
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::decrypt(const std::wstring& cipher_text, unsigned threads)
+{
+    size_t n = cipher_text.size();
+    unsigned workers = workerCount(threads, n);
+    if (workers == 1) {
+        return decrypt(cipher_text);
+    }
+
+    const wchar_t* in = cipher_text.data();
+    size_t part = (n + workers - 1) / workers;
+    std::wstring result(n, L'\0');
+    wchar_t* out = &result[0];
+    runWorkers(workers, [&](unsigned t) {
+        size_t begin = std::min(n, t * part);
+        size_t end = std::min(n, begin + part);
+        size_t phase = begin % key.size();
+        transform(in + begin, end - begin, out + begin, decryptStream, phase, false);
+    });
+    return result;
+}
+
+template <typename Alphabet>
+std::vector<uint8_t> basicModAlphaCipher<Alphabet>::convert(const std::wstring& s)
+{
+    std::vector<uint8_t> result;
+    result.reserve(s.size());
+    for(auto c : s) {
+        int index = table::indexOf(c);
+        if (index < 0) {
+            throw cipher_error("Character outside alphabet");
+        }
+        result.push_back(index);
+    }
+    return result;
+}
+
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::toUpperCase(const std::wstring& s)
 {
     std::wstring result = s;
     for (auto& c : result) {
-        c = std::towupper(c);
+        int index = table::foldedIndexOf(c);
+        if (index >= 0) {
+            c = table::letters[index];
+        }
     }
     return result;
 }
 
-std::wstring modAlphaCipher::removeNonAlpha(const std::wstring& s)
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::removeNonAlpha(const std::wstring& s)
 {
     std::wstring result;
     for (auto c : s) {
-        if (std::iswalpha(c)) {
+        if (table::foldedIndexOf(c) >= 0) {
             result.push_back(c);
         }
     }
     return result;
 }
 
-std::wstring modAlphaCipher::removeNonAlphaPublic(const std::wstring& s)
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::removeNonAlphaPublic(const std::wstring& s)
 {
     return toUpperCase(removeNonAlpha(s));
 }
 
-std::wstring modAlphaCipher::getValidKey(const std::wstring& s)
+template <typename Alphabet>
+std::wstring basicModAlphaCipher<Alphabet>::getValidKey(const std::wstring& s)
 {
-    if (s.empty()) {
+    switch (validateKey(s).error) {
+    case modAlphaStatus::emptyKey:
         throw cipher_error("Empty key");
+    case modAlphaStatus::invalidCharacter:
+        throw cipher_error("Invalid key: contains non-alphabetic characters");
+    case modAlphaStatus::weakKey:
+        throw cipher_error("Weak key: all characters are the same");
+    default:
+        return toUpperCase(s);
     }
-    
-    std::wstring tmp(s);
-    for (auto& c : tmp) {
-        if (!std::iswalpha(c)) {
-            throw cipher_error("Invalid key: contains non-alphabetic characters");
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::encrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const
+{
+    basicKeySchedule<Alphabet>(*this).encrypt(texts, count, out);
+}
+
+template <typename Alphabet>
+void basicModAlphaCipher<Alphabet>::decrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const
+{
+    basicKeySchedule<Alphabet>(*this).decrypt(texts, count, out);
+}
+
+// Ключ проверяется и переводится в индексы тем же кодом, что и в шифре
+template <typename Alphabet>
+basicKeySchedule<Alphabet>::basicKeySchedule(const std::wstring& skey) :
+    basicKeySchedule(basicModAlphaCipher<Alphabet>(skey))
+{
+}
+
+template <typename Alphabet>
+basicKeySchedule<Alphabet>::basicKeySchedule(const basicModAlphaCipher<Alphabet>& cipher)
+{
+    keyLength = cipher.key.size();
+    encryptRows.assign(keyLength * table::foldSpan, L'\0');
+    decryptRows.assign(keyLength * table::upperSpan, L'\0');
+    for (size_t k = 0; k < keyLength; k++) {
+        size_t shift = cipher.key[k];
+        wchar_t* encryptRow = &encryptRows[k * table::foldSpan];
+        for (size_t c = 0; c < table::foldSpan; c++) {
+            int index = table::fold[c];
+            if (index >= 0) {
+                encryptRow[c] = table::letters[(index + shift) % table::size];
+            }
         }
-        if (std::iswlower(c)) {
-            c = std::towupper(c);
+        wchar_t* decryptRow = &decryptRows[k * table::upperSpan];
+        for (size_t c = 0; c < table::upperSpan; c++) {
+            int index = table::upper[c];
+            if (index >= 0) {
+                decryptRow[c] = table::letters[(index + table::size - shift) % table::size];
+            }
         }
     }
-    
-    bool allSame = true;
-    for (size_t i = 1; i < tmp.size(); i++) {
-        if (tmp[i] != tmp[0]) {
-            allSame = false;
+}
+
+template <typename Alphabet>
+size_t basicKeySchedule<Alphabet>::scan(const wchar_t* in, size_t n, wchar_t* out, size_t& phase,
+                                        bool openText, size_t& invalid) const noexcept
+{
+    const size_t span = openText ? table::foldSpan : table::upperSpan;
+    const wchar_t base = openText ? table::foldBase : table::upperBase;
+    const wchar_t* rows = openText ? encryptRows.data() : decryptRows.data();
+    const wchar_t* row = rows + phase * span;
+    const wchar_t* last = rows + (keyLength - 1) * span;
+    wchar_t* start = out;
+    invalid = n;
+    for (size_t i = 0; i < n; i++) {
+        size_t offset = static_cast<size_t>(in[i] - base);
+        wchar_t c = offset < span ? row[offset] : L'\0';
+        if (c == L'\0') {
+            if (openText) {
+                continue;
+            }
+            invalid = i;
             break;
         }
+        *out++ = c;
+        row = row == last ? rows : row + span;
     }
-    if (allSame) {
-        throw cipher_error("Weak key: all characters are the same");
+    phase = (row - rows) / span;
+    return out - start;
+}
+
+template <typename Alphabet>
+size_t basicKeySchedule<Alphabet>::encrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const
+{
+    size_t invalid;
+    return scan(in, n, out, phase, true, invalid);
+}
+
+template <typename Alphabet>
+size_t basicKeySchedule<Alphabet>::decrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const
+{
+    size_t invalid;
+    size_t written = scan(in, n, out, phase, false, invalid);
+    if (invalid != n) {
+        throw cipher_error("Invalid cipher text: must contain only uppercase letters");
+    }
+    return written;
+}
+
+// Буфер размечается один раз под суммарную длину входов (результат не длиннее),
+// тексты пишутся подряд, неудачный текст откатывается к своему началу
+template <typename Alphabet>
+void basicKeySchedule<Alphabet>::batch(const std::wstring_view* texts, size_t count, modAlphaBatch& out,
+                                       bool openText) const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        total += texts[i].size();
     }
-    
-    return tmp;
+    out.arena.resize(total);
+    out.offsets.resize(count + 1);
+    out.status.resize(count);
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        out.offsets[i] = used;
+        size_t n = texts[i].size();
+        size_t phase = 0, invalid;
+        size_t written = scan(texts[i].data(), n, &out.arena[used], phase, openText, invalid);
+        if (invalid != n) {
+            out.status[i] = modAlphaStatus::invalidCharacter;
+        } else if (written == 0) {
+            out.status[i] = modAlphaStatus::emptyText;
+        } else {
+            out.status[i] = modAlphaStatus::ok;
+            used += written;
+        }
+    }
+    out.offsets[count] = used;
+    out.arena.resize(used);
+}
+
+template <typename Alphabet>
+void basicKeySchedule<Alphabet>::encrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const
+{
+    batch(texts, count, out, true);
 }
 
-std::wstring modAlphaCipher::getValidOpenText(const std::wstring& s)
+template <typename Alphabet>
+void basicKeySchedule<Alphabet>::decrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const
 {
-    std::wstring tmp = removeNonAlpha(s);
-    
-    if (tmp.empty()) {
+    batch(texts, count, out, false);
+}
+
+template <typename Alphabet>
+std::wstring basicKeySchedule<Alphabet>::encrypt(const std::wstring& open_text) const
+{
+    std::wstring result(open_text.size(), L'\0');
+    size_t phase = 0;
+    result.resize(encrypt(open_text.data(), open_text.size(), &result[0], phase));
+    if (result.empty()) {
         throw cipher_error("Empty open text");
     }
-    
-    return toUpperCase(tmp);
+    return result;
 }
 
-std::wstring modAlphaCipher::getValidCipherText(const std::wstring& s)
+template <typename Alphabet>
+std::wstring basicKeySchedule<Alphabet>::decrypt(const std::wstring& cipher_text) const
 {
-    if (s.empty()) {
+    if (cipher_text.empty()) {
         throw cipher_error("Empty cipher text");
     }
-    
-    for (auto c : s) {
-        if (!std::iswalpha(c) || !std::iswupper(c)) {
-            throw cipher_error("Invalid cipher text: must contain only uppercase letters");
-        }
+    std::wstring result(cipher_text.size(), L'\0');
+    size_t phase = 0;
+    decrypt(cipher_text.data(), cipher_text.size(), &result[0], phase);
+    return result;
+}
+
+template class basicModAlphaCipher<russianAlphabet>;
+template class basicModAlphaCipher<latinAlphabet>;
+template class basicModAlphaCipher<digitAlphabet>;
+template class basicKeySchedule<russianAlphabet>;
+template class basicKeySchedule<latinAlphabet>;
+template class basicKeySchedule<digitAlphabet>;
+
+modAlphaStream::modAlphaStream(const modAlphaCipher& c, mode m) :
+    cipher(c), direction(m), phase(0)
+{
+}
+
+// Дописывает результат обработки куска в out. В отличие от encrypt/decrypt
+// кусок без букв не ошибка, но недопустимый символ шифротекста - ошибка.
+void modAlphaStream::update(const wchar_t* chunk, size_t n, std::wstring& out)
+{
+    size_t base = out.size();
+    out.resize(base + n);
+    size_t written;
+    if (direction == encryption) {
+        written = cipher.encrypt(chunk, n, &out[base], phase);
+    } else {
+        written = cipher.decrypt(chunk, n, &out[base], phase);
     }
-    
-    return s;
+    out.resize(base + written);
+}
+
+std::wstring modAlphaStream::update(const std::wstring& chunk)
+{
+    std::wstring result;
+    update(chunk.data(), chunk.size(), result);
+    return result;
+}
+
+void modAlphaStream::reset()
+{
+    phase = 0;
 }
@@ -1,36 +1,215 @@
 #pragma once
 #include <vector>
+#include <cstdint>
 #include <string>
-#include <map>
-#include <cctype>
+#include <string_view>
 #include <stdexcept>
-#include <locale>
+#include "alphabet.h"
+#include "cipher.h"
 
-class cipher_error : public std::invalid_argument {
-public:
-    explicit cipher_error(const std::string& what_arg) : 
-        std::invalid_argument(what_arg) {}
+// Код ошибки для вызовов без исключений (пакет, try*, validate*)
+enum class modAlphaStatus { ok, emptyText, invalidCharacter, emptyKey, weakKey };
+
+// Итог проверки: код ошибки и позиция первого недопустимого символа
+// (для остальных ошибок position = 0)
+struct modAlphaValidation {
+    modAlphaStatus error;
+    size_t position;
+    explicit operator bool() const { return error == modAlphaStatus::ok; }
 };
 
-class modAlphaCipher
+// Результат без исключений: value при error == ok, иначе код и позиция
+struct modAlphaResult {
+    std::wstring value;
+    modAlphaStatus error;
+    size_t position;
+    explicit operator bool() const { return error == modAlphaStatus::ok; }
+};
+
+// Результаты пакета подряд в одном буфере: текст i занимает
+// arena[offsets[i], offsets[i + 1]), при ошибке status[i] != ok и он пуст.
+// Повторное использование одного объекта не выделяет память, если ёмкости хватает.
+struct modAlphaBatch {
+    std::wstring arena;
+    std::vector<size_t> offsets;
+    std::vector<modAlphaStatus> status;
+};
+
+template <typename Alphabet>
+class basicKeySchedule;
+
+// Шифр Гронсфельда над алфавитом Alphabet (см. alphabet.h). Модуль, таблицы
+// индексов и проверка принадлежности алфавиту - константы времени компиляции.
+// Реализация в modAlphaCipher.cpp инстанцирована для russianAlphabet,
+// latinAlphabet и digitAlphabet.
+template <typename Alphabet>
+class basicModAlphaCipher
 {
+    friend class basicKeySchedule<Alphabet>;
+
 private:
-    std::wstring numAlpha = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
-    std::map<wchar_t, int> alphaNum;
-    std::vector<int> key;
-    
-    std::vector<int> convert(const std::wstring& s);
-    std::wstring convert(const std::vector<int>& v);
+    using table = alphabetTable<Alphabet>;
+
+    std::vector<uint8_t> key;
+    std::vector<uint8_t> encryptStream;
+    std::vector<uint8_t> decryptStream;
+
+    std::vector<uint8_t> convert(const std::wstring& s);
     std::wstring toUpperCase(const std::wstring& s);
     std::wstring getValidKey(const std::wstring& s);
-    std::wstring getValidOpenText(const std::wstring& s);
-    std::wstring getValidCipherText(const std::wstring& s);
     std::wstring removeNonAlpha(const std::wstring& s);
+    size_t scan(const wchar_t* in, size_t n, wchar_t* out, const std::vector<uint8_t>& stream,
+                size_t& phase, bool openText, size_t& invalid) const noexcept;
+    size_t transform(const wchar_t* in, size_t n, wchar_t* out,
+                     const std::vector<uint8_t>& stream, size_t& phase, bool openText) const;
+    size_t countLetters(const wchar_t* in, size_t n) const;
+    size_t transformUtf8(const char* in, size_t n, char* out,
+                         const std::vector<uint8_t>& stream, size_t& phase, bool openText) const;
 
 public:
-    modAlphaCipher() = delete;
-    modAlphaCipher(const std::wstring& skey);
+    basicModAlphaCipher() = delete;
+    basicModAlphaCipher(const std::wstring& skey);
     std::wstring encrypt(const std::wstring& open_text);
     std::wstring decrypt(const std::wstring& cipher_text);
+    // UTF-8 на входе и выходе, без промежуточной std::wstring
+    std::string encrypt(std::string_view open_text);
+    std::string decrypt(std::string_view cipher_text);
+    // Параллельный режим; threads = 0 - по числу ядер
+    std::wstring encrypt(const std::wstring& open_text, unsigned threads);
+    std::wstring decrypt(const std::wstring& cipher_text, unsigned threads);
+    // Обработка куска текста с переносом фазы ключа; в out - место под n символов,
+    // возвращает число записанных. Кусок без букв - не ошибка.
+    size_t encrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const;
+    size_t decrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const;
+    // Пакет из count текстов, каждый с начала ключа; см. basicKeySchedule
+    void encrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const;
+    void decrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const;
+    // Результат в буфер вызывающего (capacity не меньше длины входа), возвращает
+    // длину результата. out может совпадать с началом входа: символ пишется не
+    // раньше, чем прочитан. Память не выделяется.
+    size_t encrypt(std::wstring_view open_text, wchar_t* out, size_t capacity) const;
+    size_t decrypt(std::wstring_view cipher_text, wchar_t* out, size_t capacity) const;
+    size_t encrypt(std::string_view open_text, char* out, size_t capacity) const;
+    size_t decrypt(std::string_view cipher_text, char* out, size_t capacity) const;
+    // Замена текста результатом на месте
+    void encryptInPlace(std::wstring& text) const;
+    void decryptInPlace(std::wstring& text) const;
+    void encryptInPlace(std::string& text) const;
+    void decryptInPlace(std::string& text) const;
+    // Проверка без исключений и выделения памяти, без ветвления на каждый символ
+    static modAlphaValidation validateKey(const std::wstring& skey) noexcept;
+    static modAlphaValidation validateOpenText(const wchar_t* s, size_t n) noexcept;
+    static modAlphaValidation validateCipherText(const wchar_t* s, size_t n) noexcept;
+    // То же, что encrypt/decrypt, но ошибка входа возвращается в result.
+    // Нехватка памяти под результат приводит к std::terminate.
+    modAlphaResult tryEncrypt(const std::wstring& open_text) const noexcept;
+    modAlphaResult tryDecrypt(const std::wstring& cipher_text) const noexcept;
     std::wstring removeNonAlphaPublic(const std::wstring& s);
 };
+
+// Расписание ключа: для каждой позиции ключа строка подстановки, сразу
+// отображающая символ входа (в любом регистре) в символ результата, 0 - символ
+// пропускается (открытый текст) или недопустим (шифротекст). Шифрование - один
+// поиск в таблице на символ без вызова ядра сдвига. Строится один раз на ключ,
+// после построения не меняется и может использоваться из нескольких потоков.
+// Размер: |ключ| * (диапазон кодов букв обоих регистров + диапазон заглавных).
+template <typename Alphabet>
+class basicKeySchedule
+{
+private:
+    using table = alphabetTable<Alphabet>;
+
+    size_t keyLength;
+    std::vector<wchar_t> encryptRows;
+    std::vector<wchar_t> decryptRows;
+
+    // Без исключений: в invalid - позиция первого недопустимого символа шифротекста или n
+    size_t scan(const wchar_t* in, size_t n, wchar_t* out, size_t& phase,
+                bool openText, size_t& invalid) const noexcept;
+    void batch(const std::wstring_view* texts, size_t count, modAlphaBatch& out,
+               bool openText) const;
+
+public:
+    basicKeySchedule() = delete;
+    basicKeySchedule(const std::wstring& skey);
+    basicKeySchedule(const basicModAlphaCipher<Alphabet>& cipher);
+    std::wstring encrypt(const std::wstring& open_text) const;
+    std::wstring decrypt(const std::wstring& cipher_text) const;
+    // Как у basicModAlphaCipher: кусок с переносом фазы, возвращает число записанных
+    size_t encrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const;
+    size_t decrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const;
+    // Пакетная обработка: один проход по всем текстам в общий буфер out.arena,
+    // ошибки - кодами в out.status, а не исключениями
+    void encrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const;
+    void decrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const;
+    size_t size() const { return keyLength; }
+};
+
+extern template class basicModAlphaCipher<russianAlphabet>;
+extern template class basicModAlphaCipher<latinAlphabet>;
+extern template class basicModAlphaCipher<digitAlphabet>;
+extern template class basicKeySchedule<russianAlphabet>;
+extern template class basicKeySchedule<latinAlphabet>;
+extern template class basicKeySchedule<digitAlphabet>;
+
+// Расписание ключа для русского алфавита
+using modAlphaKeySchedule = basicKeySchedule<russianAlphabet>;
+
+// Шифр над русским алфавитом - прежний интерфейс поверх basicModAlphaCipher
+class modAlphaCipher : public cipherBase<modAlphaCipher>
+{
+private:
+    basicModAlphaCipher<russianAlphabet> engine;
+
+public:
+    modAlphaCipher() = delete;
+    modAlphaCipher(const std::wstring& skey) : engine(skey) {}
+    std::wstring encrypt(const std::wstring& open_text) { return engine.encrypt(open_text); }
+    std::wstring decrypt(const std::wstring& cipher_text) { return engine.decrypt(cipher_text); }
+    std::string encrypt(std::string_view open_text) { return engine.encrypt(open_text); }
+    std::string decrypt(std::string_view cipher_text) { return engine.decrypt(cipher_text); }
+    std::wstring encrypt(const std::wstring& open_text, unsigned threads) { return engine.encrypt(open_text, threads); }
+    std::wstring decrypt(const std::wstring& cipher_text, unsigned threads) { return engine.decrypt(cipher_text, threads); }
+    size_t encrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const { return engine.encrypt(in, n, out, phase); }
+    size_t decrypt(const wchar_t* in, size_t n, wchar_t* out, size_t& phase) const { return engine.decrypt(in, n, out, phase); }
+    void encrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const { engine.encrypt(texts, count, out); }
+    void decrypt(const std::wstring_view* texts, size_t count, modAlphaBatch& out) const { engine.decrypt(texts, count, out); }
+    size_t encrypt(std::wstring_view open_text, wchar_t* out, size_t capacity) const { return engine.encrypt(open_text, out, capacity); }
+    size_t decrypt(std::wstring_view cipher_text, wchar_t* out, size_t capacity) const { return engine.decrypt(cipher_text, out, capacity); }
+    size_t encrypt(std::string_view open_text, char* out, size_t capacity) const { return engine.encrypt(open_text, out, capacity); }
+    size_t decrypt(std::string_view cipher_text, char* out, size_t capacity) const { return engine.decrypt(cipher_text, out, capacity); }
+    // Общий интерфейс шифров (cipher.h): UTF-8 в буфер вызывающего
+    size_t encrypt(const char* in, size_t n, char* out, size_t capacity) const { return engine.encrypt(std::string_view(in, n), out, capacity); }
+    size_t decrypt(const char* in, size_t n, char* out, size_t capacity) const { return engine.decrypt(std::string_view(in, n), out, capacity); }
+    void encryptInPlace(std::wstring& text) const { engine.encryptInPlace(text); }
+    void decryptInPlace(std::wstring& text) const { engine.decryptInPlace(text); }
+    void encryptInPlace(std::string& text) const { engine.encryptInPlace(text); }
+    void decryptInPlace(std::string& text) const { engine.decryptInPlace(text); }
+    static modAlphaValidation validateKey(const std::wstring& skey) noexcept { return basicModAlphaCipher<russianAlphabet>::validateKey(skey); }
+    static modAlphaValidation validateOpenText(const wchar_t* s, size_t n) noexcept { return basicModAlphaCipher<russianAlphabet>::validateOpenText(s, n); }
+    static modAlphaValidation validateCipherText(const wchar_t* s, size_t n) noexcept { return basicModAlphaCipher<russianAlphabet>::validateCipherText(s, n); }
+    modAlphaResult tryEncrypt(const std::wstring& open_text) const noexcept { return engine.tryEncrypt(open_text); }
+    modAlphaResult tryDecrypt(const std::wstring& cipher_text) const noexcept { return engine.tryDecrypt(cipher_text); }
+    std::wstring removeNonAlphaPublic(const std::wstring& s) { return engine.removeNonAlphaPublic(s); }
+};
+
+// Потоковое шифрование: текст подаётся кусками любого размера, фаза ключа
+// переносится между кусками (считаются только оставленные буквы алфавита),
+// поэтому результат совпадает с однократным вызовом encrypt/decrypt.
+// Память не зависит от объёма входа - хранится только копия ключа и фаза.
+class modAlphaStream
+{
+public:
+    enum mode { encryption, decryption };
+
+private:
+    modAlphaCipher cipher;
+    mode direction;
+    size_t phase;
+
+public:
+    modAlphaStream(const modAlphaCipher& c, mode m);
+    void update(const wchar_t* chunk, size_t n, std::wstring& out);
+    std::wstring update(const std::wstring& chunk);
+    void reset();
+};
@@ -0,0 +1,318 @@
+// modAlphaCipher_bench.cpp - Замеры производительности modAlphaCipher
+#include "modAlphaCipher.h"
+#include "shiftKernel.h"
+#include "allocationCounter.h"
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cwctype>
+#include <locale>
+#include <map>
+#include <string>
+#include <vector>
+
+// Прежний конвейер: копии на каждом шаге и std::map - эталон для сравнения
+struct mapAlphabet {
+    std::wstring numAlpha = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    std::map<wchar_t, int> alphaNum;
+
+    mapAlphabet() {
+        for (unsigned i = 0; i < numAlpha.size(); i++) {
+            alphaNum[numAlpha[i]] = i;
+        }
+    }
+
+    std::wstring encrypt(const std::vector<int>& key, const std::wstring& open_text) {
+        std::wstring letters;
+        for (auto c : open_text) {
+            if (std::iswalpha(c)) {
+                letters.push_back(c);
+            }
+        }
+        std::wstring upperText = letters;
+        for (auto& c : upperText) {
+            c = std::towupper(c);
+        }
+        std::vector<int> work;
+        for (auto c : upperText) {
+            work.push_back(alphaNum[c]);
+        }
+        for (unsigned i = 0; i < work.size(); i++) {
+            work[i] = (work[i] + key[i % key.size()]) % numAlpha.size();
+        }
+        std::wstring result;
+        for (auto i : work) {
+            result.push_back(numAlpha[i]);
+        }
+        return result;
+    }
+};
+
+// Русский текст объёмом около size байт в UTF-8 (кириллица - 2 байта на символ)
+std::wstring russianText(size_t size)
+{
+    const std::wstring phrase = L"Съешь же ещё этих мягких французских булок, да выпей чаю. ";
+    std::wstring text;
+    size_t bytes = 0;
+    while (bytes < size) {
+        for (auto c : phrase) {
+            text.push_back(c);
+            bytes += c < 0x80 ? 1 : 2;
+        }
+    }
+    return text;
+}
+
+template <typename F>
+double nsPerChar(size_t chars, int repeat, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        f();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (static_cast<double>(chars) * repeat);
+}
+
+int main()
+{
+    std::locale::global(std::locale(""));
+
+    const int repeat = 5;
+    std::wstring text = russianText(1 << 20);
+    const std::wstring skey = L"СЕКРЕТНЫЙКЛЮЧ";
+
+    mapAlphabet legacy;
+    std::vector<int> key;
+    for (auto c : skey) {
+        key.push_back(legacy.alphaNum[c]);
+    }
+    modAlphaCipher cipher(skey);
+
+    if (legacy.encrypt(key, text) != cipher.encrypt(text)) {
+        std::printf("mismatch between map and table versions\n");
+        return 1;
+    }
+
+    double before = nsPerChar(text.size(), repeat, [&] { legacy.encrypt(key, text); });
+    double after = nsPerChar(text.size(), repeat, [&] { cipher.encrypt(text); });
+
+    std::printf("1 MB of Russian text, %zu chars\n", text.size());
+    std::printf("%-12s %10s\n", "lookup", "ns/char");
+    std::printf("%-12s %10.2f\n", "std::map", before);
+    std::printf("%-12s %10.2f\n", "flat table", after);
+    std::printf("speedup %.2fx\n", before / after);
+
+    std::printf("\n%-12s %12s %14s\n", "pipeline", "allocs/call", "bytes/call");
+    allocations = allocatedBytes = 0;
+    legacy.encrypt(key, text);
+    std::printf("%-12s %12zu %14zu\n", "multi-copy", allocations, allocatedBytes);
+    allocations = allocatedBytes = 0;
+    cipher.encrypt(text);
+    std::printf("%-12s %12zu %14zu\n", "fused", allocations, allocatedBytes);
+    std::wstring buffer(text.size(), L'\0');
+    allocations = allocatedBytes = 0;
+    cipher.encrypt(text, &buffer[0], buffer.size());
+    std::printf("%-12s %12zu %14zu\n", "caller buf", allocations, allocatedBytes);
+    std::wstring work = text;
+    allocations = allocatedBytes = 0;
+    cipher.encryptInPlace(work);
+    std::printf("%-12s %12zu %14zu\n", "in place", allocations, allocatedBytes);
+
+    // Инстанцирования по алфавитам: обёртка, русский и латинский движки, цифры
+    {
+        std::wstring latin;
+        std::wstring digits;
+        for (size_t i = 0; latin.size() < text.size(); i++) {
+            latin.push_back(i % 6 == 5 ? L' ' : L'a' + (i * 7) % 26);
+            digits.push_back(i % 6 == 5 ? L'-' : L'0' + (i * 7) % 10);
+        }
+        basicModAlphaCipher<russianAlphabet> russian(skey);
+        basicModAlphaCipher<latinAlphabet> latinCipher(L"SECRETKEY");
+        basicModAlphaCipher<digitAlphabet> digitCipher(L"31415926");
+        std::printf("\n%-22s %10s\n", "alphabet", "ns/char");
+        std::printf("%-22s %10.2f\n", "modAlphaCipher",
+                    nsPerChar(text.size(), repeat, [&] { cipher.encrypt(text); }));
+        std::printf("%-22s %10.2f\n", "russianAlphabet",
+                    nsPerChar(text.size(), repeat, [&] { russian.encrypt(text); }));
+        std::printf("%-22s %10.2f\n", "latinAlphabet",
+                    nsPerChar(latin.size(), repeat, [&] { latinCipher.encrypt(latin); }));
+        std::printf("%-22s %10.2f\n", "digitAlphabet",
+                    nsPerChar(digits.size(), repeat, [&] { digitCipher.encrypt(digits); }));
+    }
+
+    // Короткие сообщения: шифр против расписания ключа, результат в готовый буфер
+    {
+        modAlphaKeySchedule schedule(skey);
+        std::wstring out(text.size(), L'\0');
+        std::printf("\n%8s %14s %14s %10s\n", "bytes", "cipher ns/ch", "schedule ns/ch", "speedup");
+        for (size_t bytes = 16; bytes <= 64 * 1024; bytes *= 4) {
+            std::wstring message = text.substr(0, bytes / 2);
+            int calls = static_cast<int>((64 << 20) / bytes);
+            double viaCipher = nsPerChar(message.size(), calls, [&] {
+                size_t phase = 0;
+                cipher.encrypt(message.data(), message.size(), &out[0], phase);
+            });
+            double viaSchedule = nsPerChar(message.size(), calls, [&] {
+                size_t phase = 0;
+                schedule.encrypt(message.data(), message.size(), &out[0], phase);
+            });
+            std::printf("%8zu %14.2f %14.2f %9.2fx\n", bytes, viaCipher, viaSchedule, viaCipher / viaSchedule);
+        }
+    }
+
+    // Пакет из 1M коротких сообщений (20-200 символов, 3% с латиницей - в
+    // шифротексте это ошибка): поштучные вызовы с исключениями против пакета
+    {
+        const size_t messages = 1 << 20;
+        std::vector<std::wstring> open(messages);
+        for (size_t i = 0; i < messages; i++) {
+            size_t length = 20 + (i * 7919) % 181;
+            open[i] = text.substr((i * 104729) % (text.size() - length), length);
+        }
+        std::vector<std::wstring> encrypted(messages);
+        for (size_t i = 0; i < messages; i++) {
+            encrypted[i] = cipher.encrypt(open[i]);
+            if (i % 33 == 0) {
+                encrypted[i][encrypted[i].size() / 2] = L'x';
+            }
+        }
+        std::vector<std::wstring_view> openViews(open.begin(), open.end());
+        std::vector<std::wstring_view> cipherViews(encrypted.begin(), encrypted.end());
+        modAlphaBatch batch;
+        cipher.encrypt(openViews.data(), messages, batch);
+
+        auto seconds = [](auto f) {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count();
+        };
+        size_t failures = 0;
+        double singleEncrypt = seconds([&] {
+            for (const auto& message : open) {
+                std::wstring result = cipher.encrypt(message);
+            }
+        });
+        double singleDecrypt = seconds([&] {
+            for (const auto& message : encrypted) {
+                try {
+                    std::wstring result = cipher.decrypt(message);
+                } catch (const cipher_error&) {
+                    failures++;
+                }
+            }
+        });
+        double batchEncrypt = seconds([&] { cipher.encrypt(openViews.data(), messages, batch); });
+        double batchDecrypt = seconds([&] { cipher.decrypt(cipherViews.data(), messages, batch); });
+        size_t batchFailures = 0;
+        for (auto status : batch.status) {
+            batchFailures += status != modAlphaStatus::ok;
+        }
+        if (failures != batchFailures) {
+            std::printf("batch error count mismatch\n");
+            return 1;
+        }
+        std::printf("\nbatch of %zu messages, %zu invalid\n%-10s %14s %14s %10s\n", messages, failures,
+                    "direction", "single Mmsg/s", "batch Mmsg/s", "speedup");
+        std::printf("%-10s %14.2f %14.2f %9.2fx\n", "encrypt", messages / singleEncrypt / 1e6,
+                    messages / batchEncrypt / 1e6, singleEncrypt / batchEncrypt);
+        std::printf("%-10s %14.2f %14.2f %9.2fx\n", "decrypt", messages / singleDecrypt / 1e6,
+                    messages / batchDecrypt / 1e6, singleDecrypt / batchDecrypt);
+    }
+
+    // Доля некорректных шифротекстов 0%, 3%, 50%: исключения против tryDecrypt
+    {
+        const size_t messages = 200000;
+        std::printf("\n%-8s %14s %14s %10s\n", "invalid", "throw ns/msg", "noexcept ns/msg", "speedup");
+        for (unsigned percent : { 0u, 3u, 50u }) {
+            std::vector<std::wstring> inputs(messages);
+            for (size_t i = 0; i < messages; i++) {
+                inputs[i] = cipher.encrypt(text.substr((i * 104729) % (text.size() - 120), 120));
+                if ((i * 7) % 100 < percent) {
+                    inputs[i][inputs[i].size() / 2] = L' ';
+                }
+            }
+            size_t thrown = 0, returned = 0;
+            double viaThrow = nsPerChar(messages, 1, [&] {
+                for (const auto& input : inputs) {
+                    try {
+                        cipher.decrypt(input);
+                    } catch (const cipher_error&) {
+                        thrown++;
+                    }
+                }
+            });
+            double viaResult = nsPerChar(messages, 1, [&] {
+                for (const auto& input : inputs) {
+                    returned += !cipher.tryDecrypt(input);
+                }
+            });
+            if (thrown != returned) {
+                std::printf("error count mismatch\n");
+                return 1;
+            }
+            std::printf("%7u%% %14.1f %14.1f %9.2fx\n", percent, viaThrow, viaResult, viaThrow / viaResult);
+        }
+    }
+
+    // Ядро сдвига отдельно: 64 МБ индексов, ключ из 13 символов
+    std::vector<uint8_t> indices(64 << 20);
+    for (size_t i = 0; i < indices.size(); i++) {
+        indices[i] = i % 33;
+    }
+    std::vector<uint8_t> keyIndices(key.begin(), key.end());
+    std::vector<uint8_t> stream = makeKeyStream(keyIndices);
+    std::printf("\n%-8s %10s\n", "isa", "GB/s");
+    shiftIsa levels[] = { shiftIsa::scalar, shiftIsa::sse2, shiftIsa::avx2 };
+    for (auto isa : levels) {
+        if (!shiftIsaSupported(isa)) {
+            continue;
+        }
+        double ns = nsPerChar(indices.size(), repeat, [&] {
+            shiftIndices(indices.data(), indices.size(), stream.data(), keyIndices.size(), 0, 33, isa);
+        });
+        std::printf("%-8s %10.2f\n", shiftIsaName(isa), 1.0 / ns);
+    }
+
+    // UTF-8: цепочка wstring_convert -> encrypt -> обратно против прямого пути, 100 МБ
+    {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+        std::wstring_convert<std::codecvt_utf8<wchar_t>> converter;
+        std::string utf8 = converter.to_bytes(russianText(100 << 20));
+        std::string chained, direct;
+        double chain = nsPerChar(utf8.size(), 1, [&] {
+            chained = converter.to_bytes(cipher.encrypt(converter.from_bytes(utf8)));
+        });
+#pragma GCC diagnostic pop
+        double fast = nsPerChar(utf8.size(), 1, [&] { direct = cipher.encrypt(std::string_view(utf8)); });
+        if (chained != direct) {
+            std::printf("UTF-8 mismatch\n");
+            return 1;
+        }
+        std::printf("\nUTF-8, %zu MB\n%-16s %10s\n", utf8.size() >> 20, "path", "MB/s");
+        std::printf("%-16s %10.1f\n", "wstring chain", 1e3 / chain);
+        std::printf("%-16s %10.1f\n", "direct UTF-8", 1e3 / fast);
+        std::printf("speedup %.2fx\n", chain / fast);
+    }
+
+    // Масштабирование параллельного режима: 32M символов
+    std::wstring large;
+    large.reserve(32 << 20);
+    while (large.size() + text.size() <= large.capacity()) {
+        large += text;
+    }
+    std::printf("\nparallel, %zu chars\n%8s %12s %12s %10s\n", large.size(), "threads", "enc ns/char", "dec ns/char", "speedup");
+    std::wstring encrypted = cipher.encrypt(large);
+    double base = 0;
+    for (unsigned threads = 1; threads <= 32; threads *= 2) {
+        double enc = nsPerChar(large.size(), 1, [&] { cipher.encrypt(large, threads); });
+        double dec = nsPerChar(encrypted.size(), 1, [&] { cipher.decrypt(encrypted, threads); });
+        if (threads == 1) {
+            base = enc;
+        }
+        std::printf("%8u %12.2f %12.2f %9.2fx\n", threads, enc, dec, base / enc);
+    }
+    return 0;
+}
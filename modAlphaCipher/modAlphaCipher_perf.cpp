@@ -0,0 +1,65 @@
+// modAlphaCipher_perf.cpp - Машинно-читаемые замеры modAlphaCipher (JSON, см. perfSuite.h)
+#include "modAlphaCipher.h"
+#include "perfSuite.h"
+#include "allocationCounter.h"
+#include <string>
+
+// Русский текст в UTF-8 ровно из bytes байт; chars - число символов
+static std::string russianText(size_t bytes, size_t& chars)
+{
+    const std::string phrase = "Съешь же ещё этих мягких французских булок, да выпей чаю. ";
+    std::string text;
+    text.reserve(bytes + phrase.size());
+    while (text.size() < bytes) {
+        text += phrase;
+    }
+    text.resize(bytes);
+    // Не обрываем последний символ посередине
+    while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0xC0) == 0x80) {
+        text.pop_back();
+    }
+    if (!text.empty() && static_cast<unsigned char>(text.back()) >= 0xC0) {
+        text.back() = ' ';
+    }
+    text.resize(bytes, ' ');
+    chars = 0;
+    for (unsigned char c : text) {
+        chars += (c & 0xC0) != 0x80;
+    }
+    return text;
+}
+
+// Ключ длины n без повторов подряд (не слабый)
+static std::wstring keyOfLength(size_t n)
+{
+    const std::wstring letters = L"АБВГДЕЁЖЗИЙКЛМНОПРСТУФХЦЧШЩЪЫЬЭЮЯ";
+    std::wstring key;
+    for (size_t i = 0; i < n; i++) {
+        key.push_back(letters[(i * 7 + 3) % letters.size()]);
+    }
+    return key;
+}
+
+int main(int argc, char** argv)
+{
+    perfSuite suite("modAlphaCipher", &allocations, argc, argv);
+    const size_t keyLengths[] = { 4, 16, 64 };
+
+    for (size_t bytes : suite.sizes()) {
+        size_t chars = 0;
+        std::string text = russianText(bytes, chars);
+        std::string out(bytes, '\0');
+        for (size_t length : keyLengths) {
+            modAlphaCipher cipher(keyOfLength(length));
+            std::string encrypted = cipher.encrypt(std::string_view(text));
+            size_t letters = encrypted.size() / 2;
+            suite.run("encrypt", length, bytes, bytes, chars, [&] { cipher.encrypt(std::string_view(text)); });
+            suite.run("decrypt", length, bytes, encrypted.size(), letters, [&] { cipher.decrypt(std::string_view(encrypted)); });
+            suite.run("encrypt_into", length, bytes, bytes, chars,
+                      [&] { cipher.encrypt(std::string_view(text), &out[0], out.size()); });
+            suite.run("decrypt_into", length, bytes, encrypted.size(), letters,
+                      [&] { cipher.decrypt(std::string_view(encrypted), &out[0], out.size()); });
+        }
+    }
+    return suite.finish();
+}
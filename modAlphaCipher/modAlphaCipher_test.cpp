@@ -1,10 +1,14 @@
 // modAlphaCipher_test.cpp - Тестовые модули для UnitTest++
 #include "modAlphaCipher.h"
+#include "shiftKernel.h"
+#include "allocationCounter.h"
+#include "sharedInstance.h"
 #include <UnitTest++/UnitTest++.h>
 #include <iostream>
 #include <locale>
 #include <codecvt>
 #include <string>
+#include <algorithm>
 
 // Вспомогательные функции
 std::wstring s2ws(const std::string& str) {
@@ -38,23 +42,6 @@ bool no_throw_decrypt(modAlphaCipher& cipher, const std::wstring& text) {
     }
 }
 
-// Глобальная установка локали
-struct LocaleSetup {
-    LocaleSetup() {
-        try {
-            std::locale::global(std::locale("ru_RU.UTF-8"));
-        } catch (...) {
-            try {
-                std::locale::global(std::locale(""));
-            } catch (...) {
-                std::locale::global(std::locale("C"));
-            }
-        }
-    }
-};
-
-LocaleSetup global_locale;
-
 SUITE(ConstructorTests)
 {
     TEST(ValidRussianKey) {
@@ -91,6 +78,10 @@ SUITE(ConstructorTests)
         CHECK_THROW(modAlphaCipher cipher(L""), cipher_error);
     }
     
+    TEST(LatinLettersInKey) {
+        CHECK_THROW(modAlphaCipher cipher(L"KEY"), cipher_error);
+    }
+    
     TEST(WeakKeySameLetters) {
         CHECK_THROW(modAlphaCipher cipher(L"ААА"), cipher_error);
     }
@@ -162,15 +153,7 @@ SUITE(DecryptTestsRussian)
         std::wstring encrypted = p->encrypt(original);
         std::wstring decrypted = p->decrypt(encrypted);
         
-        // Удаляем не-буквы из оригинала для сравнения
-        std::wstring original_clean;
-        for (wchar_t c : original) {
-            if (std::iswalpha(c)) {
-                original_clean += std::towupper(c);
-            }
-        }
-        
-        std::string orig_str = ws2s(original_clean);
+        std::string orig_str = "ПРИМЕРТЕКСТАКАКДЕЛА";
         std::string dec_str = ws2s(decrypted);
         CHECK_EQUAL(orig_str, dec_str);
     }
@@ -194,6 +177,10 @@ SUITE(DecryptTestsRussian)
     TEST_FIXTURE(RussianKeyFixture, EmptyCipherText) {
         CHECK_THROW(p->decrypt(L""), cipher_error);
     }
+    
+    TEST_FIXTURE(RussianKeyFixture, InvalidCipherTextLatin) {
+        CHECK_THROW(p->decrypt(L"ПРИВЕТHELLO"), cipher_error);
+    }
 }
 
 SUITE(SpecificAlgorithmTests)
@@ -321,6 +308,394 @@ SUITE(AlgorithmCorrectnessTests)
     }
 }
 
+SUITE(StreamTests)
+{
+    TEST(ChunkedEqualsOneShot) {
+        modAlphaCipher cipher(L"СЕКРЕТНЫЙКЛЮЧ");
+        std::wstring text;
+        for (int i = 0; i < 200; i++) {
+            text += L"Пример текста, 123 и ещё! ";
+        }
+        std::wstring expected = cipher.encrypt(text);
+        
+        size_t sizes[] = { 1, 3, 7, 13, 4096, 5000 };
+        for (size_t chunk : sizes) {
+            modAlphaStream enc(cipher, modAlphaStream::encryption);
+            std::wstring encrypted;
+            for (size_t pos = 0; pos < text.size(); pos += chunk) {
+                encrypted += enc.update(text.substr(pos, chunk));
+            }
+            CHECK(expected == encrypted);
+            
+            modAlphaStream dec(cipher, modAlphaStream::decryption);
+            std::wstring decrypted;
+            for (size_t pos = 0; pos < encrypted.size(); pos += chunk) {
+                decrypted += dec.update(encrypted.substr(pos, chunk));
+            }
+            CHECK(cipher.decrypt(expected) == decrypted);
+        }
+    }
+    
+    TEST(ChunkWithoutLetters) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        modAlphaStream enc(cipher, modAlphaStream::encryption);
+        CHECK(enc.update(L"123, !").empty());
+        CHECK(enc.update(L"ПРИВЕТ") == cipher.encrypt(L"ПРИВЕТ"));
+    }
+    
+    TEST(InvalidCipherChunk) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        modAlphaStream dec(cipher, modAlphaStream::decryption);
+        CHECK_THROW(dec.update(L"ПРИ ВЕТ"), cipher_error);
+    }
+    
+    TEST(ResetRestartsKey) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        modAlphaStream enc(cipher, modAlphaStream::encryption);
+        enc.update(L"ПРИ");
+        enc.reset();
+        CHECK(enc.update(L"ПРИВЕТ") == cipher.encrypt(L"ПРИВЕТ"));
+    }
+}
+
+SUITE(ParallelTests)
+{
+    TEST(ParallelEqualsSerial) {
+        modAlphaCipher cipher(L"СЕКРЕТНЫЙКЛЮЧ");
+        std::wstring text;
+        for (int i = 0; i < 12000; i++) {
+            text += L"Пример текста, 123 и ещё! ";
+        }
+        std::wstring encrypted = cipher.encrypt(text);
+        std::wstring decrypted = cipher.decrypt(encrypted);
+        unsigned counts[] = { 0, 2, 3, 8 };
+        for (unsigned threads : counts) {
+            CHECK(encrypted == cipher.encrypt(text, threads));
+            CHECK(decrypted == cipher.decrypt(encrypted, threads));
+        }
+    }
+    
+    TEST(ParallelErrors) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        std::wstring noLetters(300000, L'1');
+        CHECK_THROW(cipher.encrypt(noLetters, 4), cipher_error);
+        std::wstring badCipher(300000, L'А');
+        badCipher[250000] = L' ';
+        CHECK_THROW(cipher.decrypt(badCipher, 4), cipher_error);
+    }
+}
+
+SUITE(Utf8Tests)
+{
+    TEST(Utf8MatchesWide) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        std::string texts[] = {
+            "Пример, текста! Как дела?",
+            "Съешь же ещё этих мягких французских булок, да выпей чаю",
+            "ЁЛКА ёлка 123 latin € 😀 Я"
+        };
+        for (const auto& text : texts) {
+            std::string encrypted = cipher.encrypt(std::string_view(text));
+            CHECK_EQUAL(ws2s(cipher.encrypt(s2ws(text))), encrypted);
+            CHECK_EQUAL(ws2s(cipher.decrypt(s2ws(encrypted))), cipher.decrypt(std::string_view(encrypted)));
+        }
+    }
+    
+    TEST(Utf8Errors) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        CHECK_THROW(cipher.encrypt(std::string_view("")), cipher_error);
+        CHECK_THROW(cipher.encrypt(std::string_view("abc 123")), cipher_error);
+        CHECK_THROW(cipher.encrypt(std::string_view("ПРИ\xD0")), cipher_error);
+        CHECK_THROW(cipher.encrypt(std::string_view("\xC0\xAF")), cipher_error);
+        CHECK_THROW(cipher.encrypt(std::string_view("\xED\xA0\x80")), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::string_view("")), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::string_view("ПРИ ВЕТ")), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::string_view("привет")), cipher_error);
+    }
+}
+
+SUITE(AlphabetTests)
+{
+    TEST(LatinRoundTrip) {
+        basicModAlphaCipher<latinAlphabet> cipher(L"key");
+        // Ключ KEY = (10, 4, 24): H+10=R, E+4=I, L+24=J, L+10=V, O+4=S
+        CHECK(L"RIJVS" == cipher.encrypt(std::wstring(L"Hello, мир!")));
+        CHECK(L"HELLO" == cipher.decrypt(std::wstring(L"RIJVS")));
+        CHECK_EQUAL("RIJVS", cipher.encrypt(std::string_view("Hello, мир!")));
+        CHECK_EQUAL("HELLO", cipher.decrypt(std::string_view("RIJVS")));
+    }
+
+    TEST(LatinRejectsCyrillic) {
+        CHECK_THROW(basicModAlphaCipher<latinAlphabet> cipher(L"КЛЮЧ"), cipher_error);
+        basicModAlphaCipher<latinAlphabet> cipher(L"KEY");
+        CHECK_THROW(cipher.encrypt(std::wstring(L"ПРИВЕТ")), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::wstring(L"ПРИВЕТ")), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::string_view("rijvs")), cipher_error);
+    }
+
+    TEST(DigitRoundTrip) {
+        basicModAlphaCipher<digitAlphabet> cipher(L"19");
+        std::wstring encrypted = cipher.encrypt(std::wstring(L"tel. 8-800-555"));
+        CHECK(L"9719646" == encrypted);
+        CHECK(L"8800555" == cipher.decrypt(encrypted));
+        CHECK_EQUAL("9719646", cipher.encrypt(std::string_view("tel. 8-800-555")));
+        CHECK_THROW(cipher.decrypt(std::wstring(L"12A")), cipher_error);
+    }
+
+    TEST(WrapperMatchesRussian) {
+        modAlphaCipher wrapper(L"ПАРОЛЬ");
+        basicModAlphaCipher<russianAlphabet> engine(L"ПАРОЛЬ");
+        std::wstring text = L"Съешь же ещё этих мягких французских булок";
+        CHECK(engine.encrypt(text) == wrapper.encrypt(text));
+    }
+}
+
+SUITE(KeyScheduleTests)
+{
+    TEST(MatchesCipher) {
+        std::wstring keys[] = { L"ПАРОЛЬ", L"ключ", L"СЕКРЕТНЫЙКЛЮЧДЛЯПРОВЕРКИРАСПИСАНИЯ" };
+        std::wstring texts[] = {
+            L"Я",
+            L"Пример, текста! Как дела?",
+            L"Съешь же ещё этих мягких французских булок, да выпей чаю. ЁЛКА 123 latin"
+        };
+        for (const auto& key : keys) {
+            modAlphaCipher cipher(key);
+            modAlphaKeySchedule schedule(key);
+            for (const auto& text : texts) {
+                std::wstring encrypted = cipher.encrypt(text);
+                CHECK(encrypted == schedule.encrypt(text));
+                CHECK(cipher.decrypt(encrypted) == schedule.decrypt(encrypted));
+            }
+        }
+    }
+
+    TEST(ChunksCarryPhase) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        modAlphaKeySchedule schedule(L"ПАРОЛЬ");
+        std::wstring text = L"Съешь же ещё этих мягких французских булок";
+        std::wstring out(text.size(), L'\0');
+        size_t phase = 0, written = 0;
+        for (size_t i = 0; i < text.size(); i += 5) {
+            size_t n = std::min<size_t>(5, text.size() - i);
+            written += schedule.encrypt(text.data() + i, n, &out[written], phase);
+        }
+        out.resize(written);
+        CHECK(cipher.encrypt(text) == out);
+    }
+
+    TEST(SharedAcrossThreads) {
+        const modAlphaKeySchedule schedule(L"СЕКРЕТНЫЙКЛЮЧ");
+        std::wstring text = L"Пример текста для проверки";
+        std::wstring expected = schedule.encrypt(text);
+        CHECK_EQUAL(0u, sharedInstanceMismatches(4, 1000, [&](size_t) {
+            return schedule.encrypt(text) == expected;
+        }));
+    }
+
+    TEST(Errors) {
+        CHECK_THROW(modAlphaKeySchedule schedule(L""), cipher_error);
+        CHECK_THROW(modAlphaKeySchedule schedule(L"ААА"), cipher_error);
+        CHECK_THROW(modAlphaKeySchedule schedule(L"KEY"), cipher_error);
+        modAlphaKeySchedule schedule(L"КЛЮЧ");
+        CHECK_THROW(schedule.encrypt(std::wstring(L"123 abc")), cipher_error);
+        CHECK_THROW(schedule.decrypt(std::wstring(L"")), cipher_error);
+        CHECK_THROW(schedule.decrypt(std::wstring(L"ПРИ ВЕТ")), cipher_error);
+        CHECK_THROW(schedule.decrypt(std::wstring(L"привет")), cipher_error);
+    }
+
+    TEST(LatinSchedule) {
+        basicKeySchedule<latinAlphabet> schedule(L"key");
+        CHECK(L"RIJVS" == schedule.encrypt(std::wstring(L"Hello, мир!")));
+        CHECK(L"HELLO" == schedule.decrypt(std::wstring(L"RIJVS")));
+    }
+}
+
+SUITE(BatchTests)
+{
+    TEST(BatchMatchesSingleCalls) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        std::vector<std::wstring> texts = {
+            L"Пример, текста!", L"Я", L"Съешь же ещё этих мягких французских булок", L"ёлка"
+        };
+        std::vector<std::wstring_view> views(texts.begin(), texts.end());
+        modAlphaBatch encrypted;
+        cipher.encrypt(views.data(), views.size(), encrypted);
+        CHECK_EQUAL(texts.size() + 1, encrypted.offsets.size());
+        std::vector<std::wstring_view> cipherViews;
+        for (size_t i = 0; i < texts.size(); i++) {
+            CHECK(encrypted.status[i] == modAlphaStatus::ok);
+            std::wstring item = encrypted.arena.substr(encrypted.offsets[i],
+                                                       encrypted.offsets[i + 1] - encrypted.offsets[i]);
+            CHECK(cipher.encrypt(texts[i]) == item);
+            cipherViews.push_back(std::wstring_view(encrypted.arena).substr(encrypted.offsets[i],
+                                                                            item.size()));
+        }
+        modAlphaBatch decrypted;
+        cipher.decrypt(cipherViews.data(), cipherViews.size(), decrypted);
+        for (size_t i = 0; i < texts.size(); i++) {
+            CHECK(decrypted.status[i] == modAlphaStatus::ok);
+            CHECK(cipher.removeNonAlphaPublic(texts[i]) ==
+                  decrypted.arena.substr(decrypted.offsets[i], decrypted.offsets[i + 1] - decrypted.offsets[i]));
+        }
+    }
+
+    TEST(ErrorsPerItem) {
+        modAlphaKeySchedule schedule(L"КЛЮЧ");
+        std::wstring_view open[] = { L"привет", L"123 abc", L"", L"мир" };
+        modAlphaBatch out;
+        schedule.encrypt(open, 4, out);
+        CHECK(out.status[0] == modAlphaStatus::ok);
+        CHECK(out.status[1] == modAlphaStatus::emptyText);
+        CHECK(out.status[2] == modAlphaStatus::emptyText);
+        CHECK(out.status[3] == modAlphaStatus::ok);
+        CHECK_EQUAL(out.offsets[1], out.offsets[3]);
+        CHECK(schedule.encrypt(std::wstring(L"мир")) == out.arena.substr(out.offsets[3]));
+
+        std::wstring_view cipherText[] = { L"ПРИВЕТ", L"ПРИ ВЕТ", L"", L"привет" };
+        schedule.decrypt(cipherText, 4, out);
+        CHECK(out.status[0] == modAlphaStatus::ok);
+        CHECK(out.status[1] == modAlphaStatus::invalidCharacter);
+        CHECK(out.status[2] == modAlphaStatus::emptyText);
+        CHECK(out.status[3] == modAlphaStatus::invalidCharacter);
+        CHECK_EQUAL(6u, out.arena.size());
+        CHECK_EQUAL(6u, out.offsets[4]);
+    }
+}
+
+SUITE(NoThrowTests)
+{
+    TEST(ResultMatchesThrowingApi) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        std::wstring text = L"Съешь же ещё этих мягких французских булок";
+        modAlphaResult encrypted = cipher.tryEncrypt(text);
+        CHECK(encrypted);
+        CHECK(cipher.encrypt(text) == encrypted.value);
+        modAlphaResult decrypted = cipher.tryDecrypt(encrypted.value);
+        CHECK(decrypted);
+        CHECK(cipher.decrypt(encrypted.value) == decrypted.value);
+    }
+
+    TEST(ErrorCodes) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        CHECK(cipher.tryEncrypt(L"123 abc").error == modAlphaStatus::emptyText);
+        CHECK(cipher.tryDecrypt(L"").error == modAlphaStatus::emptyText);
+        modAlphaResult bad = cipher.tryDecrypt(L"ПРИ ВЕТ");
+        CHECK(!bad);
+        CHECK(bad.error == modAlphaStatus::invalidCharacter);
+        CHECK_EQUAL(3u, bad.position);
+        CHECK(bad.value.empty());
+        CHECK(modAlphaCipher::validateKey(L"").error == modAlphaStatus::emptyKey);
+        CHECK(modAlphaCipher::validateKey(L"ааА").error == modAlphaStatus::weakKey);
+        CHECK(modAlphaCipher::validateKey(L"КЛЮЧ1").error == modAlphaStatus::invalidCharacter);
+        CHECK_EQUAL(4u, modAlphaCipher::validateKey(L"КЛЮЧ1").position);
+        CHECK(modAlphaCipher::validateKey(L"ключ"));
+        CHECK(modAlphaCipher::validateOpenText(L"12 ё", 4));
+        CHECK(!modAlphaCipher::validateOpenText(L"12 e", 4));
+    }
+
+    TEST(PositionAcrossBlocks) {
+        // Позиции по обе стороны границ блоков проверки и преобразования
+        modAlphaCipher cipher(L"КЛЮЧ");
+        size_t positions[] = { 0, 1, 255, 256, 257, 4095, 4096, 4097, 9999 };
+        for (size_t position : positions) {
+            std::wstring text(10000, L'Ж');
+            text[position] = L'ж';
+            modAlphaValidation status = modAlphaCipher::validateCipherText(text.data(), text.size());
+            CHECK(status.error == modAlphaStatus::invalidCharacter);
+            CHECK_EQUAL(position, status.position);
+            CHECK_EQUAL(position, cipher.tryDecrypt(text).position);
+        }
+    }
+}
+
+SUITE(BufferTests)
+{
+    TEST(BufferMatchesString) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        std::wstring text = L"Пример, текста! Как дела?";
+        std::wstring out(text.size(), L'\0');
+        size_t length = cipher.encrypt(text, &out[0], out.size());
+        CHECK(cipher.encrypt(text) == out.substr(0, length));
+        CHECK_THROW(cipher.encrypt(text, &out[0], text.size() - 1), cipher_error);
+        CHECK_THROW(cipher.encrypt(std::wstring_view(L"123"), &out[0], out.size()), cipher_error);
+        CHECK_THROW(cipher.decrypt(std::wstring_view(L"ПР ИВ"), &out[0], out.size()), cipher_error);
+    }
+
+    TEST(InPlaceRoundTrip) {
+        modAlphaCipher cipher(L"ПАРОЛЬ");
+        std::wstring text = L"Съешь же ещё этих мягких французских булок";
+        std::wstring work = text;
+        cipher.encryptInPlace(work);
+        CHECK(cipher.encrypt(text) == work);
+        cipher.decryptInPlace(work);
+        CHECK(cipher.removeNonAlphaPublic(text) == work);
+
+        std::string utf8 = "Съешь же ещё этих мягких французских булок";
+        std::string expected = cipher.encrypt(std::string_view(utf8));
+        cipher.encryptInPlace(utf8);
+        CHECK_EQUAL(expected, utf8);
+        cipher.decryptInPlace(utf8);
+        CHECK_EQUAL(ws2s(cipher.removeNonAlphaPublic(text)), utf8);
+    }
+
+    TEST(NoAllocationsAfterWarmUp) {
+        modAlphaCipher cipher(L"СЕКРЕТНЫЙКЛЮЧ");
+        std::wstring text = L"Съешь же ещё этих мягких французских булок, да выпей чаю.";
+        std::string utf8 = ws2s(text);
+        std::wstring wide(text.size(), L'\0');
+        std::string narrow(utf8.size(), '\0');
+        std::wstring work;
+        work.reserve(text.size());
+        cipher.encrypt(text, &wide[0], wide.size());
+
+        allocations = 0;
+        for (int i = 0; i < 100; i++) {
+            size_t length = cipher.encrypt(text, &wide[0], wide.size());
+            cipher.decrypt(std::wstring_view(wide.data(), length), &wide[0], wide.size());
+            length = cipher.encrypt(utf8, &narrow[0], narrow.size());
+            cipher.decrypt(std::string_view(narrow.data(), length), &narrow[0], narrow.size());
+            work.assign(text);
+            cipher.encryptInPlace(work);
+            cipher.decryptInPlace(work);
+        }
+        CHECK_EQUAL(0u, allocations);
+        // Счётчик работает: возврат новой строки выделяет память
+        cipher.encrypt(text);
+        CHECK(allocations > 0);
+    }
+}
+
+SUITE(ShiftKernelTests)
+{
+    TEST(AllIsaMatchModulo) {
+        const uint8_t modulus = 33;
+        shiftIsa levels[] = { shiftIsa::scalar, shiftIsa::sse2, shiftIsa::avx2 };
+        for (size_t keyLength = 1; keyLength <= 70; keyLength += 3) {
+            std::vector<uint8_t> key(keyLength);
+            for (size_t i = 0; i < keyLength; i++) {
+                key[i] = (i * 7 + keyLength) % modulus;
+            }
+            std::vector<uint8_t> stream = makeKeyStream(key);
+            std::vector<uint8_t> source(1000 + keyLength);
+            std::vector<uint8_t> expected(source.size());
+            for (size_t i = 0; i < source.size(); i++) {
+                source[i] = (i * 13 + 5) % modulus;
+                expected[i] = (source[i] + key[i % keyLength]) % modulus;
+            }
+            for (auto isa : levels) {
+                if (!shiftIsaSupported(isa)) {
+                    continue;
+                }
+                std::vector<uint8_t> work = source;
+                size_t phase = shiftIndices(work.data(), work.size(), stream.data(), keyLength, 0, modulus, isa);
+                CHECK(work == expected);
+                CHECK_EQUAL(source.size() % keyLength, phase);
+            }
+        }
+    }
+}
+
 SUITE(ErrorHandlingTests)
 {
     TEST(InvalidCharactersInOpenText) {
@@ -411,6 +786,22 @@ SUITE(AdditionalTests)
         CHECK_EQUAL(enc_lower_str, enc_upper_str);
     }
     
+    TEST(IndependentOfLocale) {
+        // Тесты идут в локали "C": регистр и принадлежность алфавиту
+        // определяются таблицей шифра, а не std::towupper/std::iswalpha
+        std::locale::global(std::locale::classic());
+        modAlphaCipher cipher(L"ключ");
+        CHECK_EQUAL(ws2s(cipher.encrypt(L"ПРИВЕТЁ")), ws2s(cipher.encrypt(L"привет, ё!")));
+        CHECK_EQUAL("ПРИВЕТЁ", ws2s(cipher.removeNonAlphaPublic(L"привет, ё!")));
+    }
+    
+    TEST(LatinLettersRemoved) {
+        modAlphaCipher cipher(L"КЛЮЧ");
+        std::string enc1_str = ws2s(cipher.encrypt(L"ПРИ hello ВЕТ"));
+        std::string enc2_str = ws2s(cipher.encrypt(L"ПРИВЕТ"));
+        CHECK_EQUAL(enc2_str, enc1_str);
+    }
+    
     TEST(SpacesRemoved) {
         modAlphaCipher cipher(L"КЛЮЧ");
         std::wstring with_spaces = L"П Р И В Е Т";
@@ -425,8 +816,6 @@ SUITE(AdditionalTests)
 }
 
 int main(int argc, char** argv) {
-    std::locale::global(std::locale(""));
-    
     std::cout << "=== Запуск тестов modAlphaCipher с русским языком ===" << std::endl;
     
     return UnitTest::RunAllTests();
@@ -0,0 +1,129 @@
+#include "shiftKernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHIFT_KERNEL_X86 1
+#endif
+
+static size_t shiftScalar(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                          size_t phase, uint8_t modulus)
+{
+    for (size_t i = 0; i < n; i++) {
+        unsigned sum = data[i] + keyStream[phase];
+        data[i] = sum >= modulus ? sum - modulus : sum;
+        if (++phase == keyLength) {
+            phase = 0;
+        }
+    }
+    return phase;
+}
+
+#ifdef SHIFT_KERNEL_X86
+// Для x < m и k < m <= 128: min(x + k, x + k - m) по беззнаковым байтам
+// равен (x + k) mod m - при x + k < m вычитание переполняется и даёт большее число
+static size_t shiftSse2(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                        size_t phase, uint8_t modulus)
+{
+    const __m128i m = _mm_set1_epi8(static_cast<char>(modulus));
+    const size_t step = 16 % keyLength;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keyStream + phase));
+        __m128i s = _mm_add_epi8(x, k);
+        s = _mm_min_epu8(s, _mm_sub_epi8(s, m));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), s);
+        phase += step;
+        if (phase >= keyLength) {
+            phase -= keyLength;
+        }
+    }
+    return shiftScalar(data + i, n - i, keyStream, keyLength, phase, modulus);
+}
+
+__attribute__((target("avx2")))
+static size_t shiftAvx2(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                        size_t phase, uint8_t modulus)
+{
+    const __m256i m = _mm256_set1_epi8(static_cast<char>(modulus));
+    const size_t step = 32 % keyLength;
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keyStream + phase));
+        __m256i s = _mm256_add_epi8(x, k);
+        s = _mm256_min_epu8(s, _mm256_sub_epi8(s, m));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), s);
+        phase += step;
+        if (phase >= keyLength) {
+            phase -= keyLength;
+        }
+    }
+    return shiftSse2(data + i, n - i, keyStream, keyLength, phase, modulus);
+}
+#endif
+
+bool shiftIsaSupported(shiftIsa isa)
+{
+    switch (isa) {
+    case shiftIsa::scalar:
+        return true;
+#ifdef SHIFT_KERNEL_X86
+    case shiftIsa::sse2:
+        return __builtin_cpu_supports("sse2");
+    case shiftIsa::avx2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+shiftIsa detectShiftIsa()
+{
+    static const shiftIsa best = shiftIsaSupported(shiftIsa::avx2) ? shiftIsa::avx2
+                               : shiftIsaSupported(shiftIsa::sse2) ? shiftIsa::sse2
+                               : shiftIsa::scalar;
+    return best;
+}
+
+const char* shiftIsaName(shiftIsa isa)
+{
+    switch (isa) {
+    case shiftIsa::sse2:
+        return "sse2";
+    case shiftIsa::avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+std::vector<uint8_t> makeKeyStream(const std::vector<uint8_t>& key)
+{
+    std::vector<uint8_t> stream(key.size() + shiftLanes);
+    for (size_t i = 0; i < stream.size(); i++) {
+        stream[i] = key[i % key.size()];
+    }
+    return stream;
+}
+
+size_t shiftIndices(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                    size_t phase, uint8_t modulus, shiftIsa isa)
+{
+#ifdef SHIFT_KERNEL_X86
+    if (isa == shiftIsa::avx2) {
+        return shiftAvx2(data, n, keyStream, keyLength, phase, modulus);
+    }
+    if (isa == shiftIsa::sse2) {
+        return shiftSse2(data, n, keyStream, keyLength, phase, modulus);
+    }
+#endif
+    return shiftScalar(data, n, keyStream, keyLength, phase, modulus);
+}
+
+size_t shiftIndices(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                    size_t phase, uint8_t modulus)
+{
+    return shiftIndices(data, n, keyStream, keyLength, phase, modulus, detectShiftIsa());
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Набор инструкций, на котором выполняется ядро сдвига
+enum class shiftIsa { scalar, sse2, avx2 };
+
+// Ключевой поток: ключ, дополненный своим началом на shiftLanes символов,
+// чтобы блок из shiftLanes сдвигов читался одной загрузкой с любой фазы
+const size_t shiftLanes = 32;
+
+shiftIsa detectShiftIsa();
+const char* shiftIsaName(shiftIsa isa);
+bool shiftIsaSupported(shiftIsa isa);
+
+std::vector<uint8_t> makeKeyStream(const std::vector<uint8_t>& key);
+
+// data[i] = (data[i] + key[(phase + i) % keyLength]) % modulus, без деления:
+// сложение и вычитание модуля по сравнению. Требуется data[i] < modulus <= 128.
+// Возвращает фазу ключа после последнего символа.
+size_t shiftIndices(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                    size_t phase, uint8_t modulus, shiftIsa isa);
+size_t shiftIndices(uint8_t* data, size_t n, const uint8_t* keyStream, size_t keyLength,
+                    size_t phase, uint8_t modulus);
@@ -0,0 +1,124 @@
+#include "permutationCache.h"
+#include "cipherError.h"
+
+routePermutation::routePermutation(size_t n) : length(n)
+{
+    if (n > maxLength) {
+        throw cipher_error("Text is too long for a route permutation");
+    }
+    if (n <= 65536) {
+        narrow.resize(2 * n);
+    } else {
+        wide.resize(2 * n);
+    }
+}
+
+size_t routePermutation::bytes() const
+{
+    return narrow.size() * sizeof(uint16_t) + wide.size() * sizeof(uint32_t);
+}
+
+void routePermutation::set(size_t p, size_t position)
+{
+    if (isNarrow()) {
+        narrow[p] = static_cast<uint16_t>(position);
+        narrow[length + position] = static_cast<uint16_t>(p);
+    } else {
+        wide[p] = static_cast<uint32_t>(position);
+        wide[length + position] = static_cast<uint32_t>(p);
+    }
+}
+
+template <typename Index>
+static void gather(const Index* index, size_t begin, size_t end, const char* in, char* out)
+{
+    for (size_t i = begin; i < end; i++) {
+        out[i] = in[index[i]];
+    }
+}
+
+void routePermutation::encrypt(const char* in, char* out, size_t begin, size_t end) const
+{
+    if (isNarrow()) {
+        gather(narrow.data() + length, begin, end, in, out);
+    } else {
+        gather(wide.data() + length, begin, end, in, out);
+    }
+}
+
+void routePermutation::decrypt(const char* in, char* out, size_t begin, size_t end) const
+{
+    if (isNarrow()) {
+        gather(narrow.data(), begin, end, in, out);
+    } else {
+        gather(wide.data(), begin, end, in, out);
+    }
+}
+
+permutationCache::permutationCache(size_t capacityBytes) :
+    capacity(capacityBytes), used(0), counters()
+{
+}
+
+// Вытесняет самые давние записи, пока не освободится needed байт
+void permutationCache::evict(size_t needed)
+{
+    while (!order.empty() && used + needed > capacity) {
+        used -= order.back().second->bytes();
+        index.erase(order.back().first);
+        order.pop_back();
+        counters.evictions++;
+    }
+}
+
+permutationCache::handle permutationCache::get(uint64_t routeId, size_t key, size_t n, const builder& build)
+{
+    entryKey id(routeId, key, n);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto found = index.find(id);
+        if (found != index.end()) {
+            counters.hits++;
+            order.splice(order.begin(), order, found->second);
+            return found->second->second;
+        }
+        counters.misses++;
+    }
+
+    std::shared_ptr<routePermutation> built = std::make_shared<routePermutation>(n);
+    build(*built);
+    handle result = built;
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = index.find(id);
+    if (found != index.end()) {
+        // Другой поток успел построить ту же перестановку
+        order.splice(order.begin(), order, found->second);
+        return found->second->second;
+    }
+    size_t bytes = result->bytes();
+    if (bytes <= capacity) {
+        evict(bytes);
+        order.emplace_front(id, result);
+        index[id] = order.begin();
+        used += bytes;
+    }
+    return result;
+}
+
+permutationCache::stats permutationCache::statistics() const
+{
+    std::lock_guard<std::mutex> guard(lock);
+    stats result = counters;
+    result.entries = order.size();
+    result.bytes = used;
+    return result;
+}
+
+void permutationCache::clear()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    order.clear();
+    index.clear();
+    used = 0;
+}
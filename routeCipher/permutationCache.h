@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Готовая перестановка для текста длины length в обе стороны: position[p] -
+// место символа p открытого текста в шифротексте, source[q] - обратная к ней.
+// И шифрование, и расшифрование - последовательная запись со сбором по индексам
+// (разброс при записи медленнее из-за шага в строку таблицы).
+// Индексы 16-битные, если длина позволяет; в narrow/wide сначала position, затем source.
+// Текст длиннее maxLength (32-битные индексы) - cipher_error.
+struct routePermutation {
+    static constexpr size_t maxLength = size_t(UINT32_MAX) + 1;
+    size_t length;
+    std::vector<uint16_t> narrow;
+    std::vector<uint32_t> wide;
+
+    explicit routePermutation(size_t n);
+    bool isNarrow() const { return narrow.size() == 2 * length; }
+    size_t bytes() const;
+    void set(size_t p, size_t position);
+    size_t position(size_t p) const { return isNarrow() ? narrow[p] : wide[p]; }
+    // Результат только в out[begin, end) - для разбиения между потоками
+    void encrypt(const char* in, char* out, size_t begin, size_t end) const;
+    void decrypt(const char* in, char* out, size_t begin, size_t end) const;
+    void encrypt(const char* in, char* out) const { encrypt(in, out, 0, length); }
+    void decrypt(const char* in, char* out) const { decrypt(in, out, 0, length); }
+};
+
+// LRU-кэш перестановок по (маршрут, ключ, длина текста) с ограничением по байтам индексов.
+// Перестановка больше всей ёмкости строится, но не сохраняется. Выданная
+// перестановка остаётся действительной и после вытеснения из кэша.
+// Потокобезопасен; один кэш можно отдать нескольким шифрам.
+class permutationCache
+{
+public:
+    struct stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t entries;
+        size_t bytes;
+    };
+
+    typedef std::shared_ptr<const routePermutation> handle;
+    typedef std::function<void(routePermutation&)> builder;
+
+private:
+    typedef std::tuple<uint64_t, size_t, size_t> entryKey;
+    typedef std::list<std::pair<entryKey, handle>> entryList;
+
+    size_t capacity;
+    size_t used;
+    stats counters;
+    entryList order;
+    std::map<entryKey, entryList::iterator> index;
+    mutable std::mutex lock;
+
+    void evict(size_t needed);
+
+public:
+    explicit permutationCache(size_t capacityBytes);
+    // Перестановка для (routeId, key, n); при промахе строится через build вне блокировки
+    handle get(uint64_t routeId, size_t key, size_t n, const builder& build);
+    stats statistics() const;
+    void clear();
+};
@@ -0,0 +1,139 @@
+#include "route.h"
+#include "permutationCache.h"
+#include "routeCipher.h"
+
+#include <algorithm>
+
+// FNV-1a: 64-битная сигнатура описания маршрута для ключа кэша
+route::route(const std::string& description) : signature(14695981039346656037ull)
+{
+    for (unsigned char c : description) {
+        signature = (signature ^ c) * 1099511628211ull;
+    }
+}
+
+columnRoute::columnRoute() : route("column")
+{
+}
+
+void columnRoute::walk(size_t rows, size_t columns, const visitor& visit) const
+{
+    for (size_t c = columns; c-- > 0;) {
+        for (size_t r = 0; r < rows; r++) {
+            visit(r, c);
+        }
+    }
+}
+
+snakeRoute::snakeRoute() : route("snake")
+{
+}
+
+void snakeRoute::walk(size_t rows, size_t columns, const visitor& visit) const
+{
+    for (size_t k = 0; k < columns; k++) {
+        size_t c = columns - 1 - k;
+        for (size_t i = 0; i < rows; i++) {
+            visit(k % 2 == 0 ? i : rows - 1 - i, c);
+        }
+    }
+}
+
+spiralRoute::spiralRoute() : route("spiral")
+{
+}
+
+void spiralRoute::walk(size_t rows, size_t columns, const visitor& visit) const
+{
+    if (rows == 0 || columns == 0) {
+        return;
+    }
+    size_t top = 0, bottom = rows - 1, left = 0, right = columns - 1;
+    while (top <= bottom && left <= right) {
+        for (size_t c = left; c <= right; c++) {
+            visit(top, c);
+        }
+        for (size_t r = top + 1; r <= bottom; r++) {
+            visit(r, right);
+        }
+        if (top < bottom && left < right) {
+            for (size_t c = right; c-- > left;) {
+                visit(bottom, c);
+            }
+            for (size_t r = bottom; --r > top;) {
+                visit(r, left);
+            }
+        }
+        if (bottom == 0 || right == 0) {
+            break;
+        }
+        top++;
+        bottom--;
+        left++;
+        right--;
+    }
+}
+
+diagonalRoute::diagonalRoute() : route("diagonal")
+{
+}
+
+void diagonalRoute::walk(size_t rows, size_t columns, const visitor& visit) const
+{
+    for (size_t d = 0; d + 1 < rows + columns; d++) {
+        size_t first = d >= columns ? d - columns + 1 : 0;
+        size_t last = std::min(rows - 1, d);
+        for (size_t r = first; r <= last; r++) {
+            visit(r, d - r);
+        }
+    }
+}
+
+static std::string validKeyword(const std::string& keyword)
+{
+    if (keyword.empty()) {
+        throw cipher_error("Empty keyword");
+    }
+    if (!routeCipher::validateCipherText(keyword.data(), keyword.size())) {
+        throw cipher_error("Keyword contains invalid characters");
+    }
+    return keyword;
+}
+
+keywordRoute::keywordRoute(const std::string& keyword) : route("keyword:" + validKeyword(keyword))
+{
+    std::string upper = keyword;
+    for (auto& c : upper) {
+        c &= ~0x20;
+    }
+    order.resize(upper.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return upper[a] < upper[b]; });
+}
+
+void keywordRoute::walk(size_t rows, size_t columns, const visitor& visit) const
+{
+    for (size_t c : order) {
+        if (c >= columns) {
+            continue;
+        }
+        for (size_t r = 0; r < rows; r++) {
+            visit(r, c);
+        }
+    }
+}
+
+void compileRoute(const route& r, size_t columns, routePermutation& permutation)
+{
+    size_t n = permutation.length;
+    size_t rows = (n + columns - 1) / columns;
+    size_t next = 0;
+    r.walk(rows, columns, [&](size_t row, size_t column) {
+        size_t p = row * columns + column;
+        if (p < n) {
+            permutation.set(p, next++);
+        }
+    });
+}
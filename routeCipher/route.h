@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct routePermutation;
+
+// Маршрут чтения таблицы rows x columns, заполненной текстом по строкам.
+// Маршрут только перечисляет клетки полной таблицы в порядке чтения; пустые
+// клетки последней строки отбрасываются при компиляции в перестановку, после
+// чего шифрование по любому маршруту - один проход сбора по индексам.
+class route
+{
+private:
+    uint64_t signature;
+
+protected:
+    // description однозначно описывает маршрут с параметрами (ключ кэша перестановок)
+    explicit route(const std::string& description);
+
+public:
+    typedef std::function<void(size_t row, size_t column)> visitor;
+
+    virtual ~route() {}
+    // Число столбцов, если маршрут его задаёт (ключевое слово), иначе 0
+    virtual size_t columns() const { return 0; }
+    virtual void walk(size_t rows, size_t columns, const visitor& visit) const = 0;
+    uint64_t id() const { return signature; }
+};
+
+// Столбцы справа налево, каждый сверху вниз - маршрут routeCipher по умолчанию
+class columnRoute : public route
+{
+public:
+    columnRoute();
+    void walk(size_t rows, size_t columns, const visitor& visit) const override;
+};
+
+// Змейка: столбцы справа налево, направление чередуется (вниз, вверх, вниз...)
+class snakeRoute : public route
+{
+public:
+    snakeRoute();
+    void walk(size_t rows, size_t columns, const visitor& visit) const override;
+};
+
+// Спираль по часовой стрелке от левого верхнего угла к центру
+class spiralRoute : public route
+{
+public:
+    spiralRoute();
+    void walk(size_t rows, size_t columns, const visitor& visit) const override;
+};
+
+// Диагонали r + c = const от левого верхнего угла, каждая сверху вниз
+class diagonalRoute : public route
+{
+public:
+    diagonalRoute();
+    void walk(size_t rows, size_t columns, const visitor& visit) const override;
+};
+
+// Столбцы в алфавитном порядке букв ключевого слова (равные - слева направо),
+// каждый сверху вниз; число столбцов - длина слова
+class keywordRoute : public route
+{
+private:
+    std::vector<size_t> order;
+
+public:
+    explicit keywordRoute(const std::string& keyword);
+    size_t columns() const override { return order.size(); }
+    void walk(size_t rows, size_t columns, const visitor& visit) const override;
+};
+
+// Перестановка для текста длины permutation.length в таблице из columns столбцов
+void compileRoute(const route& r, size_t columns, routePermutation& permutation);
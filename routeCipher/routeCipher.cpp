@@ -1,168 +1,748 @@
 #include "routeCipher.h"
+#include "transposeKernel.h"
+#include "parallel.h"
+#include "byteClass.h"
 
 #include <algorithm>
+#include <cstring>
+#include <exception>
+#include <limits>
 #include <string>
+#include <thread>
 #include <vector>
-#include <iostream>
 #include <stdexcept>
 
+static bool isLetter(char c)
+{
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+// Позиция первого символа не из (буквы + пробелы, если allowSpaces) или n;
+// hasLetters - есть ли буквы до этой позиции
+static size_t scanText(const char* s, size_t n, bool allowSpaces, bool& hasLetters)
+{
+    unsigned anyLetters = 0;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        unsigned letters, spaces;
+        classify(s + i, letters, spaces);
+        unsigned valid = allowSpaces ? letters | spaces : letters;
+        anyLetters |= letters;
+        if (valid != 0xFFFF) {
+            hasLetters = anyLetters != 0;
+            return i + __builtin_ctz(~valid);
+        }
+    }
+    hasLetters = anyLetters != 0;
+    for (; i < n; i++) {
+        if (isLetter(s[i])) {
+            hasLetters = true;
+        } else if (!allowSpaces || s[i] != ' ') {
+            return i;
+        }
+    }
+    return n;
+}
+
+// Открытый текст без пробелов. Без пробелов - сам вход, иначе копия в буфере
+// потока: так шифр не хранит изменяемого состояния, а повторные вызовы в одном
+// потоке не выделяют память. Буфер больше scratchLimit освобождается в конце
+// вызова, чтобы поток не удерживал память под самый длинный текст.
+class compactText
+{
+private:
+    static constexpr size_t scratchLimit = 1 << 20;
+    std::string* scratch;
+
+public:
+    const char* data;
+    size_t size;
+
+    compactText(const char* s, size_t n) : scratch(nullptr), data(s), size(n)
+    {
+        if (!std::memchr(s, ' ', n)) {
+            return;
+        }
+        static thread_local std::string buffer;
+        scratch = &buffer;
+        scratch->clear();
+        for (size_t i = 0; i < n; i++) {
+            if (s[i] != ' ') {
+                scratch->push_back(s[i]);
+            }
+        }
+        data = scratch->data();
+        size = scratch->size();
+    }
+
+    ~compactText()
+    {
+        if (scratch && scratch->capacity() > scratchLimit) {
+            std::string().swap(*scratch);
+        }
+    }
+
+    compactText(const compactText&) = delete;
+    compactText& operator=(const compactText&) = delete;
+};
+
+routeCipher::validation routeCipher::validateKey(int k) noexcept
+{
+    return { k > 0 ? ok : invalidKey, 0 };
+}
+
+routeCipher::validation routeCipher::validateOpenText(const char* s, size_t n) noexcept
+{
+    if (n == 0) {
+        return { emptyText, 0 };
+    }
+    bool hasLetters;
+    size_t position = scanText(s, n, true, hasLetters);
+    if (position != n) {
+        return { invalidCharacter, position };
+    }
+    return { hasLetters ? ok : noLetters, 0 };
+}
+
+routeCipher::validation routeCipher::validateCipherText(const char* s, size_t n) noexcept
+{
+    if (n == 0) {
+        return { emptyText, 0 };
+    }
+    bool hasLetters;
+    size_t position = scanText(s, n, false, hasLetters);
+    if (position != n) {
+        return { invalidCharacter, position };
+    }
+    return { ok, 0 };
+}
+
 std::string routeCipher::getValidKey(int k)
 {
-    if (k <= 0) {
+    if (!validateKey(k)) {
         throw cipher_error("Key must be a positive integer");
     }
     return std::to_string(k);
 }
 
-std::string routeCipher::getValidOpenText(const std::string& s)
+void routeCipher::getValidOpenText(const char* s, size_t n) const
 {
-    if (s.empty()) {
+    switch (validateOpenText(s, n).error) {
+    case emptyText:
         throw cipher_error("Empty open text");
-    }
-    
-    bool has_letters = false;
-    for (char c : s) {
-        if (std::isalpha(c)) {
-            has_letters = true;
-        } else if (c != ' ') {
-            throw cipher_error("Open text contains invalid characters");
-        }
-    }
-    
-    if (!has_letters) {
+    case invalidCharacter:
+        throw cipher_error("Open text contains invalid characters");
+    case noLetters:
         throw cipher_error("Open text does not contain letters");
+    default:
+        return;
     }
-    
-    return s;
 }
 
-std::string routeCipher::getValidCipherText(const std::string& s)
+void routeCipher::getValidCipherText(const char* s, size_t n) const
 {
-    if (s.empty()) {
+    switch (validateCipherText(s, n).error) {
+    case emptyText:
         throw cipher_error("Empty cipher text");
+    case invalidCharacter:
+        throw cipher_error("Cipher text contains invalid characters");
+    default:
+        return;
     }
-    
-    for (char c : s) {
-        if (!std::isalpha(c)) {
-            throw cipher_error("Cipher text contains invalid characters");
-        }
-    }
-    
+}
+
+const std::string& routeCipher::getValidOpenText(const std::string& s) const
+{
+    getValidOpenText(s.data(), s.size());
+    return s;
+}
+
+const std::string& routeCipher::getValidCipherText(const std::string& s) const
+{
+    getValidCipherText(s.data(), s.size());
     return s;
 }
 
-routeCipher::routeCipher(int k)
+routeCipher::routeCipher(int k, std::ostream* trace_sink, permutationCache* permutation_cache)
 {
     getValidKey(k);
     key = k;
+    trace = trace_sink;
+    cache = permutation_cache;
 }
 
-std::string routeCipher::encrypt(const std::string& open_text)
+routeCipher::routeCipher(int k, std::shared_ptr<const route> read_route, std::ostream* trace_sink,
+                         permutationCache* permutation_cache) :
+    routeCipher(k, trace_sink, permutation_cache)
 {
-    try {
-        std::string validText = getValidOpenText(open_text);
-        
-        if(validText.empty()) {
-            return "";
-        }
+    if (!read_route) {
+        throw cipher_error("Route is not set");
+    }
+    if (read_route->columns() != 0 && read_route->columns() != static_cast<size_t>(k)) {
+        throw cipher_error("Key does not match the route");
+    }
+    path = read_route;
+    // Обход маршрута - вызов visitor на каждую клетку, поэтому без кэша он
+    // повторялся бы при каждом encrypt/decrypt
+    if (!cache) {
+        ownCache = std::make_shared<permutationCache>(routeCacheBytes);
+        cache = ownCache.get();
+    }
+}
 
-        std::string text_no_spaces;
-        
-        for(char c : validText) {
-            if(c != ' ') {
-                text_no_spaces += std::toupper(c);
-            }
+// Смещение столбца column в шифротексте: столбцы читаются справа налево,
+// первые full столбцов содержат rows символов, остальные rows - 1
+size_t routeCipher::columnOffset(size_t column, size_t rows, size_t full) const
+{
+    size_t key_size = static_cast<size_t>(key);
+    size_t offset = (key_size - 1 - column) * (rows - 1);
+    if (full > column + 1) {
+        offset += full - 1 - column;
+    }
+    return offset;
+}
+
+size_t routeCipher::columnOffsets(size_t n, size_t* offsets) const
+{
+    size_t key_size = static_cast<size_t>(key);
+    size_t rows = (n + key_size - 1) / key_size;
+    size_t full = n % key_size == 0 ? key_size : n % key_size;
+    size_t columns = std::min(key_size, n);
+    for (size_t j = 0; j < columns; j++) {
+        offsets[j] = columnOffset(j, rows, full);
+    }
+    return columns;
+}
+
+// Отладочная печать таблицы - только если при создании передан поток trace
+void routeCipher::printTable(const char* title, const std::string& text, size_t rows) const
+{
+    if (!trace) {
+        return;
+    }
+    *trace << title << '\n';
+    for(size_t i = 0; i < rows; i++) {
+        for(int j = 0; j < key; j++) {
+            size_t pos = i * key + j;
+            *trace << (pos < text.length() ? text[pos] : ' ') << ' ';
         }
+        *trace << '\n';
+    }
+}
 
-        if(text_no_spaces.empty()) {
-            return "";
+// Маршрутная перестановка уже нормализованного текста (без пробелов, в верхнем
+// регистре) и обратная к ней. Заполняется только участок шифротекста [begin, end):
+// столбцы идут справа налево подряд, поэтому участок - это хвост одного столбца,
+// несколько целых столбцов и начало следующего. Так потоки делят работу поровну
+// при любом key. Целые столбцы переставляются плитками, неполные - поэлементно.
+void routeCipher::permute(const char* in, size_t n, char* out, size_t begin, size_t end, bool inverse) const
+{
+    size_t key_size = static_cast<size_t>(key);
+    size_t rows = (n + key_size - 1) / key_size;
+    size_t full = n % key_size == 0 ? key_size : n % key_size;
+    bool tiled = transposeTileSize(key_size) != 0;
+
+    size_t wholeLo = key_size, wholeHi = 0;
+    for(size_t j = std::min(key_size, n); j-- > 0;) {
+        size_t offset = columnOffset(j, rows, full);
+        size_t height = j < full ? rows : rows - 1;
+        if (offset >= end) {
+            break;
+        }
+        if (offset + height <= begin) {
+            continue;
         }
+        size_t first = std::max(begin, offset) - offset;
+        size_t last = std::min(end, offset + height) - offset;
+        if (tiled && first == 0 && last == height) {
+            wholeLo = std::min(wholeLo, j);
+            wholeHi = std::max(wholeHi, j + 1);
+            continue;
+        }
+        permuteColumn(in, out, j, offset, first, last, inverse);
+    }
+    if (wholeLo < wholeHi) {
+        permuteBlock(in, n, out, wholeLo, wholeHi, inverse);
+    }
+}
 
-        size_t text_length = text_no_spaces.length();
-        size_t key_size = static_cast<size_t>(key);
-        size_t rows = (text_length + key_size - 1) / key_size;
+// Строки first..last-1 столбца j, который начинается в шифротексте с offset
+void routeCipher::permuteColumn(const char* in, char* out, size_t j, size_t offset,
+                                size_t first, size_t last, bool inverse) const
+{
+    size_t key_size = static_cast<size_t>(key);
+    if (inverse) {
+        const char* src = in + offset + first;
+        char* dst = out + first * key_size + j;
+        for(size_t i = first; i < last; i++, dst += key_size) {
+            *dst = *src++;
+        }
+    } else {
+        const char* src = in + first * key_size + j;
+        char* dst = out + offset + first;
+        for(size_t i = first; i < last; i++, src += key_size) {
+            *dst++ = *src;
+        }
+    }
+}
 
-        std::vector<std::vector<char>> table(rows, std::vector<char>(key, ' '));
+// Целые столбцы [jLo, jHi). Полосы по 64 столбца проходятся сверху вниз плитками,
+// так что чтение строк использует строки кэша целиком, а запись идёт в 64 потока.
+void routeCipher::permuteBlock(const char* in, size_t n, char* out, size_t jLo, size_t jHi, bool inverse) const
+{
+    const size_t band = 64;
+    size_t key_size = static_cast<size_t>(key);
+    size_t rows = (n + key_size - 1) / key_size;
+    size_t full = n % key_size == 0 ? key_size : n % key_size;
+    size_t dense = full == key_size ? rows : rows - 1;
+    size_t tile = transposeTileSize(key_size);
+    size_t rowEnd = dense / tile * tile;
 
-        size_t index = 0;
-        for(size_t i = 0; i < rows; i++) {
-            for(int j = 0; j < key; j++) {
-                if(index < text_length) {
-                    table[i][j] = text_no_spaces[index++];
+    const char* src[16];
+    char* dst[16];
+    for (size_t jb = jLo; jb < jHi; jb += band) {
+        size_t je = std::min(jHi, jb + band);
+        size_t tileEnd = jb + (je - jb) / tile * tile;
+        for (size_t i0 = 0; i0 < rowEnd; i0 += tile) {
+            for (size_t j0 = jb; j0 < tileEnd; j0 += tile) {
+                for (size_t t = 0; t < tile; t++) {
+                    size_t offset = columnOffset(j0 + t, rows, full) + i0;
+                    size_t row = (i0 + t) * key_size + j0;
+                    if (inverse) {
+                        src[t] = in + offset;
+                        dst[t] = out + row;
+                    } else {
+                        src[t] = in + row;
+                        dst[t] = out + offset;
+                    }
                 }
+                transposeTile(src, dst, tile);
             }
         }
+        for (size_t j = jb; j < je; j++) {
+            size_t offset = columnOffset(j, rows, full);
+            size_t first = j < tileEnd ? rowEnd : 0;
+            size_t height = j < full ? rows : rows - 1;
+            permuteColumn(in, out, j, offset, first, height, inverse);
+        }
+    }
+}
 
-        std::cout << "Encryption table:" << std::endl;
-        for(size_t i = 0; i < rows; i++) {
-            for(int j = 0; j < key; j++) {
-                std::cout << table[i][j] << " ";
-            }
-            std::cout << std::endl;
+void routeCipher::transpose(const char* in, size_t n, char* out, size_t begin, size_t end) const
+{
+    permute(in, n, out, begin, end, false);
+}
+
+void routeCipher::restore(const char* in, size_t n, char* out, size_t begin, size_t end) const
+{
+    permute(in, n, out, begin, end, true);
+}
+
+// Место каждого символа открытого текста в шифротексте - по маршруту или,
+// для маршрута по умолчанию, по тем же смещениям столбцов
+void routeCipher::buildPermutation(routePermutation& permutation) const
+{
+    if (path) {
+        compileRoute(*path, static_cast<size_t>(key), permutation);
+        return;
+    }
+    size_t n = permutation.length;
+    size_t key_size = static_cast<size_t>(key);
+    size_t rows = (n + key_size - 1) / key_size;
+    size_t full = n % key_size == 0 ? key_size : n % key_size;
+    for (size_t j = 0; j < std::min(key_size, n); j++) {
+        size_t offset = columnOffset(j, rows, full);
+        size_t height = j < full ? rows : rows - 1;
+        for (size_t i = 0; i < height; i++) {
+            permutation.set(i * key_size + j, offset + i);
         }
+    }
+}
 
-        std::string result;
-        for(int j = key - 1; j >= 0; j--) {
-            for(size_t i = 0; i < rows; i++) {
-                if(table[i][j] != ' ') {
-                    result += table[i][j];
-                }
-            }
+// Скомпилированная перестановка для длины n - из кэша, если он задан
+permutationCache::handle routeCipher::permutationFor(size_t n) const
+{
+    permutationCache::builder build = [this](routePermutation& p) { buildPermutation(p); };
+    if (cache) {
+        return cache->get(path ? path->id() : 0, key, n, build);
+    }
+    std::shared_ptr<routePermutation> built = std::make_shared<routePermutation>(n);
+    build(*built);
+    return built;
+}
+
+// Перестановка всего текста: маршрут по умолчанию без кэша - ядро по столбцам,
+// иначе - сбор по скомпилированной перестановке. Маршрут по умолчанию для
+// текста длиннее routePermutation::maxLength тоже идёт через ядро; другой
+// маршрут для такого текста - cipher_error из routePermutation.
+void routeCipher::applyPermutation(const char* in, size_t n, char* out, bool inverse) const
+{
+    if (!path && (!cache || n > routePermutation::maxLength)) {
+        permute(in, n, out, 0, n, inverse);
+    } else if (inverse) {
+        permutationFor(n)->decrypt(in, out);
+    } else {
+        permutationFor(n)->encrypt(in, out);
+    }
+}
+
+// Проверенный текст без пробелов в верхнем регистре
+std::string routeCipher::normalize(const std::string& text)
+{
+    std::string result;
+    result.reserve(text.length());
+    for (char c : text) {
+        if (c != ' ') {
+            result.push_back(c & ~0x20);
         }
+    }
+    return result;
+}
 
-        return result;
-        
-    } catch (const cipher_error& e) {
-        throw;
+std::string routeCipher::normalizeOpenText(const std::string& open_text) const
+{
+    return normalize(getValidOpenText(open_text));
+}
+
+std::string routeCipher::normalizeCipherText(const std::string& cipher_text) const
+{
+    return normalize(getValidCipherText(cipher_text));
+}
+
+std::string routeCipher::encrypt(const std::string& open_text) const
+{
+    std::string result(open_text.length(), '\0');
+    result.resize(encrypt(open_text, &result[0], result.length()));
+    return result;
+}
+
+std::string routeCipher::decrypt(const std::string& cipher_text) const
+{
+    std::string result(cipher_text.length(), '\0');
+    result.resize(decrypt(cipher_text, &result[0], result.length()));
+    return result;
+}
+
+size_t routeCipher::encrypt(const std::string& open_text, char* out, size_t capacity) const
+{
+    return encrypt(open_text.data(), open_text.size(), out, capacity);
+}
+
+size_t routeCipher::decrypt(const std::string& cipher_text, char* out, size_t capacity) const
+{
+    return decrypt(cipher_text.data(), cipher_text.size(), out, capacity);
+}
+
+// Перестановка не зависит от регистра, поэтому верхний регистр наводится
+// уже в out, а копия входа нужна только для удаления пробелов
+size_t routeCipher::encrypt(const char* open_text, size_t n, char* out, size_t capacity) const
+{
+    getValidOpenText(open_text, n);
+    compactText compact(open_text, n);
+    const char* text = compact.data;
+    n = compact.size;
+    if (capacity < n) {
+        throw cipher_error("Output buffer too small");
+    }
+
+    size_t key_size = static_cast<size_t>(key);
+    if (trace) {
+        printTable("Encryption table:", normalize(std::string(text, n)), (n + key_size - 1) / key_size);
+    }
+
+    applyPermutation(text, n, out, false);
+    for (size_t i = 0; i < n; i++) {
+        out[i] &= ~0x20;
+    }
+    return n;
+}
+
+size_t routeCipher::decrypt(const char* cipher_text, size_t n, char* out, size_t capacity) const
+{
+    getValidCipherText(cipher_text, n);
+    if (capacity < n) {
+        throw cipher_error("Output buffer too small");
     }
+
+    applyPermutation(cipher_text, n, out, true);
+    for (size_t i = 0; i < n; i++) {
+        out[i] &= ~0x20;
+    }
+
+    size_t key_size = static_cast<size_t>(key);
+    if (trace) {
+        printTable("Decryption table:", std::string(out, n), (n + key_size - 1) / key_size);
+    }
+    return n;
 }
 
-std::string routeCipher::decrypt(const std::string& cipher_text)
+routeCipher::result routeCipher::tryEncrypt(const std::string& open_text) const noexcept
 {
+    validation status = validateOpenText(open_text.data(), open_text.size());
+    if (!status) {
+        return { std::string(), status.error, status.position };
+    }
+    std::string text = normalize(open_text);
+
+    size_t key_size = static_cast<size_t>(key);
+    // Поток отладки может бросать (exceptions()); его ошибки не прерывают шифрование
     try {
-        std::string text = getValidCipherText(cipher_text);
-        std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+        printTable("Encryption table:", text, (text.length() + key_size - 1) / key_size);
+    } catch (...) {
+    }
 
-        if(text.empty()) {
-            return "";
+    std::string value(text.length(), '\0');
+    applyPermutation(text.data(), text.length(), &value[0], false);
+    return { std::move(value), ok, 0 };
+}
+
+routeCipher::result routeCipher::tryDecrypt(const std::string& cipher_text) const noexcept
+{
+    validation status = validateCipherText(cipher_text.data(), cipher_text.size());
+    if (!status) {
+        return { std::string(), status.error, status.position };
+    }
+    std::string text = normalize(cipher_text);
+
+    std::string value(text.length(), '\0');
+    applyPermutation(text.data(), text.length(), &value[0], true);
+
+    size_t key_size = static_cast<size_t>(key);
+    try {
+        printTable("Decryption table:", value, (value.length() + key_size - 1) / key_size);
+    } catch (...) {
+    }
+    return { std::move(value), ok, 0 };
+}
+
+// Параллельный режим: шифротекст делится на равные участки, каждый поток
+// собирает свой участок из столбцов таблицы прямо в общий результат
+std::string routeCipher::encrypt(const std::string& open_text, unsigned threads) const
+{
+    std::string text = normalizeOpenText(open_text);
+    size_t n = text.length();
+    unsigned workers = workerCount(threads, n);
+
+    size_t key_size = static_cast<size_t>(key);
+    printTable("Encryption table:", text, (n + key_size - 1) / key_size);
+
+    std::string result(n, '\0');
+    size_t part = (n + workers - 1) / workers;
+    permutationCache::handle permutation = path ? permutationFor(n) : nullptr;
+    runWorkers(workers, [&](unsigned t) {
+        size_t begin = std::min(n, t * part);
+        if (permutation) {
+            permutation->encrypt(text.data(), &result[0], begin, std::min(n, begin + part));
+        } else {
+            transpose(text.data(), n, &result[0], begin, std::min(n, begin + part));
         }
+    });
+    return result;
+}
 
-        size_t text_length = text.length();
-        size_t key_size = static_cast<size_t>(key);
-        size_t rows = (text_length + key_size - 1) / key_size;
+std::string routeCipher::decrypt(const std::string& cipher_text, unsigned threads) const
+{
+    std::string text = normalizeCipherText(cipher_text);
+    size_t n = text.length();
+    unsigned workers = workerCount(threads, n);
 
-        std::vector<std::vector<char>> table(rows, std::vector<char>(key, ' '));
+    std::string result(n, '\0');
+    size_t part = (n + workers - 1) / workers;
+    permutationCache::handle permutation = path ? permutationFor(n) : nullptr;
+    runWorkers(workers, [&](unsigned t) {
+        size_t begin = std::min(n, t * part);
+        if (permutation) {
+            permutation->decrypt(text.data(), &result[0], begin, std::min(n, begin + part));
+        } else {
+            restore(text.data(), n, &result[0], begin, std::min(n, begin + part));
+        }
+    });
 
-        size_t index = 0;
-        for(int j = key - 1; j >= 0; j--) {
-            for(size_t i = 0; i < rows; i++) {
-                size_t pos = i * key + j;
-                if (pos < text_length && index < text_length) {
-                    table[i][j] = text[index++];
-                }
-            }
+    size_t key_size = static_cast<size_t>(key);
+    printTable("Decryption table:", result, (n + key_size - 1) / key_size);
+    return result;
+}
+
+routeStream::routeStream(const routeCipher& c, mode m, size_t segmentRows) :
+    cipher(c), direction(m), segmentSize(0), total(0)
+{
+    if (segmentRows == 0) {
+        throw cipher_error("Segment must contain at least one row");
+    }
+    size_t key_size = static_cast<size_t>(c.key);
+    if (segmentRows > std::numeric_limits<size_t>::max() / key_size) {
+        throw cipher_error("Segment size is too large");
+    }
+    segmentSize = segmentRows * key_size;
+}
+
+// Готовая перестановка длины n, если шифр переставляет по ней (маршрут или
+// кэш), иначе пусто - ядро по столбцам памяти не выделяет
+permutationCache::handle routeStream::segmentPermutation(size_t n) const
+{
+    if (!cipher.path && (!cipher.cache || n > routePermutation::maxLength)) {
+        return permutationCache::handle();
+    }
+    return cipher.permutationFor(n);
+}
+
+// Не бросает, если out уже вмещает сегмент, а permutation получена заранее
+void routeStream::flushSegment(std::string& out, const permutationCache::handle& permutation)
+{
+    size_t base = out.size();
+    out.resize(base + segment.size());
+    bool inverse = direction == decryption;
+    if (!permutation) {
+        cipher.permute(segment.data(), segment.size(), &out[base], 0, segment.size(), inverse);
+    } else if (inverse) {
+        permutation->decrypt(segment.data(), &out[base]);
+    } else {
+        permutation->encrypt(segment.data(), &out[base]);
+    }
+    segment.clear();
+}
+
+// Сначала проверка куска и все выделения памяти, затем запись, которая уже не
+// бросает: при исключении поток и out остаются прежними
+void routeStream::update(const char* chunk, size_t n, std::string& out)
+{
+    bool hasLetters;
+    if (scanText(chunk, n, direction == encryption, hasLetters) != n) {
+        throw cipher_error(direction == encryption ? "Open text contains invalid characters"
+                                                   : "Cipher text contains invalid characters");
+    }
+    size_t letters = direction == encryption ? n - std::count(chunk, chunk + n, ' ') : n;
+    size_t pending = segment.size() + letters;
+    permutationCache::handle permutation;
+    if (pending >= segmentSize) {
+        permutation = segmentPermutation(segmentSize);
+        out.reserve(out.size() + pending / segmentSize * segmentSize);
+    }
+    segment.reserve(std::min(segmentSize, pending));
+
+    for (size_t i = 0; i < n; i++) {
+        char c = chunk[i];
+        if (c == ' ') {
+            continue;
+        }
+        segment.push_back(c & ~0x20);
+        total++;
+        if (segment.size() == segmentSize) {
+            flushSegment(out, permutation);
         }
+    }
+}
 
-        std::cout << "Decryption table:" << std::endl;
-        for(size_t i = 0; i < rows; i++) {
-            for(int j = 0; j < key; j++) {
-                std::cout << table[i][j] << " ";
+std::string routeStream::update(const std::string& chunk)
+{
+    std::string result;
+    update(chunk.data(), chunk.size(), result);
+    return result;
+}
+
+void routeStream::finish(std::string& out)
+{
+    if (total == 0) {
+        throw cipher_error(direction == encryption ? "Open text does not contain letters"
+                                                   : "Empty cipher text");
+    }
+    if (!segment.empty()) {
+        permutationCache::handle permutation = segmentPermutation(segment.size());
+        out.reserve(out.size() + segment.size());
+        flushSegment(out, permutation);
+    }
+    total = 0;
+}
+
+std::string routeStream::finish()
+{
+    std::string result;
+    finish(result);
+    return result;
+}
+
+routeChain::routeChain(const std::vector<routeCipher>& chain_passes, permutationCache* permutation_cache) :
+    passes(chain_passes), cache(permutation_cache), chainId(14695981039346656037ull)
+{
+    if (passes.empty()) {
+        throw cipher_error("Chain must contain at least one pass");
+    }
+    // Ключ кэша - FNV-1a по маршрутам и ключам проходов
+    for (const auto& pass : passes) {
+        uint64_t parts[] = { pass.path ? pass.path->id() : 0, static_cast<uint64_t>(pass.key) };
+        for (uint64_t part : parts) {
+            for (int shift = 0; shift < 64; shift += 8) {
+                chainId = (chainId ^ ((part >> shift) & 0xFF)) * 1099511628211ull;
             }
-            std::cout << std::endl;
         }
+    }
+}
 
-        std::string result;
-        for(size_t i = 0; i < rows; i++) {
-            for(int j = 0; j < key; j++) {
-                if(table[i][j] != ' ') {
-                    result += table[i][j];
-                }
+// Символ p после прохода i стоит на месте position_i(p), поэтому итоговое
+// место - последовательное применение position всех проходов
+permutationCache::handle routeChain::permutationFor(size_t n) const
+{
+    permutationCache::builder build = [this](routePermutation& combined) {
+        size_t n = combined.length;
+        std::vector<permutationCache::handle> steps;
+        for (const auto& pass : passes) {
+            steps.push_back(pass.permutationFor(n));
+        }
+        for (size_t p = 0; p < n; p++) {
+            size_t position = p;
+            for (const auto& step : steps) {
+                position = step->position(position);
             }
+            combined.set(p, position);
         }
+    };
+    if (cache) {
+        return cache->get(chainId, passes.size(), n, build);
+    }
+    std::shared_ptr<routePermutation> built = std::make_shared<routePermutation>(n);
+    build(*built);
+    return built;
+}
 
-        return result;
-        
-    } catch (const cipher_error& e) {
-        throw;
+std::string routeChain::encrypt(const std::string& open_text) const
+{
+    std::string result(open_text.length(), '\0');
+    result.resize(encrypt(open_text, &result[0], result.length()));
+    return result;
+}
+
+std::string routeChain::decrypt(const std::string& cipher_text) const
+{
+    std::string result(cipher_text.length(), '\0');
+    result.resize(decrypt(cipher_text, &result[0], result.length()));
+    return result;
+}
+
+size_t routeChain::encrypt(const std::string& open_text, char* out, size_t capacity) const
+{
+    passes.front().getValidOpenText(open_text.data(), open_text.size());
+    compactText text(open_text.data(), open_text.size());
+    size_t n = text.size;
+    if (capacity < n) {
+        throw cipher_error("Output buffer too small");
+    }
+    permutationFor(n)->encrypt(text.data, out);
+    for (size_t i = 0; i < n; i++) {
+        out[i] &= ~0x20;
+    }
+    return n;
+}
+
+size_t routeChain::decrypt(const std::string& cipher_text, char* out, size_t capacity) const
+{
+    const std::string& text = passes.front().getValidCipherText(cipher_text);
+    size_t n = text.length();
+    if (capacity < n) {
+        throw cipher_error("Output buffer too small");
+    }
+    permutationFor(n)->decrypt(text.data(), out);
+    for (size_t i = 0; i < n; i++) {
+        out[i] &= ~0x20;
     }
+    return n;
 }
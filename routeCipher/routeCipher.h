@@ -1,27 +1,178 @@
 #pragma once
+#include "cipher.h"
+#include "permutationCache.h"
+#include "route.h"
 #include <algorithm>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 #include <stdexcept>
 
-class cipher_error : public std::invalid_argument {
+class routeCipher : public cipherBase<routeCipher>
+{
 public:
-    explicit cipher_error(const std::string& what_arg) : 
-        std::invalid_argument(what_arg) {}
-};
+    // Коды ошибок проверки без исключений
+    enum errorCode { ok, invalidKey, emptyText, noLetters, invalidCharacter };
+
+    // Итог проверки: код ошибки и позиция первого недопустимого символа
+    // (для остальных ошибок position = 0)
+    struct validation {
+        errorCode error;
+        size_t position;
+        explicit operator bool() const { return error == ok; }
+    };
+
+    // Результат без исключений: value при error == ok, иначе код и позиция
+    struct result {
+        std::string value;
+        errorCode error;
+        size_t position;
+        explicit operator bool() const { return error == ok; }
+    };
 
-class routeCipher
-{
 private:
     int key;
+    std::ostream* trace;
+    permutationCache* cache;
+    std::shared_ptr<permutationCache> ownCache; // маршрут без общего кэша (общий у копий шифра)
+    std::shared_ptr<const route> path;
     std::string getValidKey(int k);
-    std::string getValidOpenText(const std::string& s);
-    std::string getValidCipherText(const std::string& s);
+    const std::string& getValidOpenText(const std::string& s) const;
+    const std::string& getValidCipherText(const std::string& s) const;
+    void getValidOpenText(const char* s, size_t n) const;
+    void getValidCipherText(const char* s, size_t n) const;
+    size_t columnOffset(size_t column, size_t rows, size_t full) const;
+    void printTable(const char* title, const std::string& text, size_t rows) const;
+    std::string normalizeOpenText(const std::string& open_text) const;
+    std::string normalizeCipherText(const std::string& cipher_text) const;
+    static std::string normalize(const std::string& text);
+    void permute(const char* in, size_t n, char* out, size_t begin, size_t end, bool inverse) const;
+    void permuteColumn(const char* in, char* out, size_t j, size_t offset,
+                       size_t first, size_t last, bool inverse) const;
+    void permuteBlock(const char* in, size_t n, char* out, size_t jLo, size_t jHi, bool inverse) const;
+    void transpose(const char* in, size_t n, char* out, size_t begin, size_t end) const;
+    void restore(const char* in, size_t n, char* out, size_t begin, size_t end) const;
+    void buildPermutation(routePermutation& permutation) const;
+    permutationCache::handle permutationFor(size_t n) const;
+    void applyPermutation(const char* in, size_t n, char* out, bool inverse) const;
+
+    friend class routeStream;
+    friend class routeChain;
 
 public:
     routeCipher() = delete;
-    routeCipher(int k);
+    // cache - необязательный общий кэш перестановок (не принадлежит шифру):
+    // для повторяющихся длин encrypt/decrypt сводятся к одному проходу по индексам
+    routeCipher(int k, std::ostream* trace_sink = nullptr, permutationCache* permutation_cache = nullptr);
+    // Другой маршрут чтения (см. route.h); он компилируется в перестановку для
+    // каждой длины текста один раз. Без общего кэша шифр заводит свой на
+    // routeCacheBytes (16 МБ индексов - тексты примерно до 2 млн символов);
+    // перестановка длиннее строится заново при каждом вызове.
+    // Сбор по готовой перестановке медленнее ядра маршрута по умолчанию:
+    // на 1 МБ при k = 64 примерно на 20-45% в зависимости от маршрута - индексы
+    // читаются из памяти, а не вычисляются по столбцам.
+    // Для keywordRoute k должен совпадать с длиной ключевого слова.
+    static constexpr size_t routeCacheBytes = 16 << 20;
+    routeCipher(int k, std::shared_ptr<const route> read_route, std::ostream* trace_sink = nullptr,
+                permutationCache* permutation_cache = nullptr);
+
+    // encrypt/decrypt не меняют шифр: один экземпляр можно вызывать из
+    // нескольких потоков одновременно (общий кэш перестановок потокобезопасен)
+    std::string encrypt(const std::string& open_text) const;
+    std::string decrypt(const std::string& cipher_text) const;
+    // Параллельный режим; threads = 0 - по числу ядер
+    std::string encrypt(const std::string& open_text, unsigned threads) const;
+    std::string decrypt(const std::string& cipher_text, unsigned threads) const;
+    // Результат в буфер вызывающего (capacity не меньше длины результата),
+    // возвращает длину результата; out не должен пересекаться со входом.
+    // Открытый текст без пробелов переставляется прямо из входа, иначе он
+    // сжимается в буфер потока (см. compactText в routeCipher.cpp): повторные
+    // вызовы на текстах до 1 МБ не выделяют память, более длинный текст
+    // копируется заново при каждом вызове.
+    size_t encrypt(const std::string& open_text, char* out, size_t capacity) const;
+    size_t decrypt(const std::string& cipher_text, char* out, size_t capacity) const;
+    // То же для входа произвольной длины в памяти вызывающего (например,
+    // отображённого файла) - без копии входа в std::string
+    size_t encrypt(const char* open_text, size_t n, char* out, size_t capacity) const;
+    size_t decrypt(const char* cipher_text, size_t n, char* out, size_t capacity) const;
+
+    int getKey() const { return key; }
+    // Начала столбцов таблицы маршрута по умолчанию в шифротексте из n букв:
+    // offsets[j] только для занятых столбцов, их min(key, n) - это и возвращается
+    size_t columnOffsets(size_t n, size_t* offsets) const;
+
+    // Проверка без исключений и выделения памяти: один проход блоками по 16 байт
+    static validation validateKey(int k) noexcept;
+    static validation validateOpenText(const char* s, size_t n) noexcept;
+    static validation validateCipherText(const char* s, size_t n) noexcept;
+    // То же, что encrypt/decrypt, но ошибка входа возвращается в result.
+    // Нехватка памяти под результат приводит к std::terminate.
+    result tryEncrypt(const std::string& open_text) const noexcept;
+    result tryDecrypt(const std::string& cipher_text) const noexcept;
+};
+
+// Потоковый режим с ограниченной памятью.
+//
+// Формат: нормализованный текст (без пробелов, в верхнем регистре) режется на
+// сегменты по segmentRows * key символов; каждый сегмент шифруется обычной
+// маршрутной перестановкой независимо от остальных, шифротексты сегментов идут
+// подряд без заголовков. Все сегменты, кроме последнего, полные, поэтому при
+// расшифровании границы восстанавливаются по длине: тот же segmentRows и key
+// режут шифротекст на те же сегменты, последний - остаток.
+// Память - не больше одного сегмента (segmentRows * key символов) независимо
+// от объёма входа; буфер сегмента растёт по мере поступления текста, поэтому
+// при большом key короткий текст стоит памяти по своей длине. Если
+// segmentRows * key не помещается в size_t, конструктор бросает cipher_error.
+// Если сегмент вмещает весь текст, результат совпадает с encrypt/decrypt.
+// update и finish при ошибке (недопустимый символ, нехватка памяти) не меняют
+// ни поток, ни out.
+class routeStream
+{
+public:
+    enum mode { encryption, decryption };
 
-    std::string encrypt(const std::string& open_text);
-    std::string decrypt(const std::string& cipher_text);
-};
\ No newline at end of file
+private:
+    routeCipher cipher;
+    mode direction;
+    size_t segmentSize;
+    size_t total;
+    std::string segment;
+
+    void flushSegment(std::string& out, const permutationCache::handle& permutation);
+    permutationCache::handle segmentPermutation(size_t n) const;
+
+public:
+    routeStream(const routeCipher& c, mode m, size_t segmentRows);
+    void update(const char* chunk, size_t n, std::string& out);
+    std::string update(const std::string& chunk);
+    void finish(std::string& out);
+    std::string finish();
+};
+
+// Многократная перестановка (например, двойная перестановка по ключевым словам):
+// текст проходит через passes по очереди. Для каждой длины текста композиция
+// перестановок всех проходов вычисляется один раз (и кэшируется, если задан
+// кэш), после чего N проходов стоят как один - один проход сбора по индексам.
+// Результат совпадает с последовательными encrypt всех проходов; отладочные
+// таблицы проходов не печатаются.
+class routeChain
+{
+private:
+    std::vector<routeCipher> passes;
+    permutationCache* cache;
+    uint64_t chainId;
+
+    permutationCache::handle permutationFor(size_t n) const;
+
+public:
+    routeChain() = delete;
+    explicit routeChain(const std::vector<routeCipher>& chain_passes,
+                        permutationCache* permutation_cache = nullptr);
+
+    // Как и у routeCipher, вызовы не меняют цепочку и безопасны из нескольких потоков
+    std::string encrypt(const std::string& open_text) const;
+    std::string decrypt(const std::string& cipher_text) const;
+    size_t encrypt(const std::string& open_text, char* out, size_t capacity) const;
+    size_t decrypt(const std::string& cipher_text, char* out, size_t capacity) const;
+};
@@ -0,0 +1,387 @@
+// routeCipher_bench.cpp - Замеры производительности routeCipher
+#include "routeCipher.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <memory>
+#include <cstdio>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Поток, отбрасывающий вывод: отладочная печать таблицы не должна влиять на замер
+class nullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Поток, считающий записанные байты и сбросы буфера
+class countingBuffer : public std::streambuf {
+public:
+    size_t bytes = 0;
+    size_t flushes = 0;
+protected:
+    int overflow(int c) override { bytes++; return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { bytes += n; return n; }
+    int sync() override { flushes++; return 0; }
+};
+
+// Прежняя реализация на двумерной таблице - эталон для сравнения
+std::string tableEncrypt(int key, const std::string& text)
+{
+    size_t text_length = text.length();
+    size_t rows = (text_length + key - 1) / key;
+    std::vector<std::vector<char>> table(rows, std::vector<char>(key, ' '));
+
+    size_t index = 0;
+    for(size_t i = 0; i < rows; i++) {
+        for(int j = 0; j < key; j++) {
+            if(index < text_length) {
+                table[i][j] = text[index++];
+            }
+        }
+    }
+
+    std::cout << "Encryption table:" << std::endl;
+    for(size_t i = 0; i < rows; i++) {
+        for(int j = 0; j < key; j++) {
+            std::cout << table[i][j] << " ";
+        }
+        std::cout << std::endl;
+    }
+
+    std::string result;
+    for(int j = key - 1; j >= 0; j--) {
+        for(size_t i = 0; i < rows; i++) {
+            if(table[i][j] != ' ') {
+                result += table[i][j];
+            }
+        }
+    }
+    return result;
+}
+
+// Построчный обход по столбцам без плиток (как до плиточного ядра):
+// проверка, нормализация и чтение столбца с шагом key
+std::string stridedEncrypt(int key, const std::string& open_text)
+{
+    std::string text;
+    text.reserve(open_text.length());
+    for (char c : open_text) {
+        if (c != ' ') {
+            if (!std::isalpha(static_cast<unsigned char>(c))) {
+                return "";
+            }
+            text.push_back(std::toupper(c));
+        }
+    }
+    size_t n = text.length();
+    size_t key_size = key;
+    std::string result(n, '\0');
+    size_t offset = 0;
+    for (size_t j = std::min(key_size, n); j-- > 0;) {
+        for (size_t pos = j; pos < n; pos += key_size) {
+            result[offset++] = text[pos];
+        }
+    }
+    return result;
+}
+
+template <typename F>
+double throughput(size_t bytes, int repeat, F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        f();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return bytes * repeat / elapsed.count() / 1e6;
+}
+
+long peakRssKb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Пиковая память потокового и однократного шифрования в зависимости от объёма.
+// Каждый замер - в отдельном дочернем процессе, чтобы пики не накапливались.
+void streamingRss()
+{
+    const int key = 64;
+    const size_t segmentRows = 1024;
+    const size_t chunk = 64 << 10;
+    std::string block(chunk, 'A');
+    for (size_t i = 0; i < chunk; i++) {
+        block[i] = 'A' + i % 26;
+    }
+
+    std::printf("%10s %18s %18s\n", "input MB", "stream peak KB", "one-shot peak KB");
+    for (size_t mb = 1; mb <= 64; mb *= 4) {
+        size_t size = mb << 20;
+        long peaks[2] = { 0, 0 };
+        for (int oneShot = 0; oneShot < 2; oneShot++) {
+            int fd[2];
+            if (pipe(fd) != 0) {
+                return;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                routeCipher cipher(key);
+                if (oneShot) {
+                    std::string text;
+                    for (size_t done = 0; done < size; done += chunk) {
+                        text += block;
+                    }
+                    cipher.encrypt(text);
+                } else {
+                    routeStream stream(cipher, routeStream::encryption, segmentRows);
+                    std::string out;
+                    for (size_t done = 0; done < size; done += chunk) {
+                        stream.update(block.data(), block.size(), out);
+                        out.clear();
+                    }
+                    stream.finish(out);
+                }
+                long peak = peakRssKb();
+                ssize_t written = write(fd[1], &peak, sizeof(peak));
+                _exit(written == sizeof(peak) ? 0 : 1);
+            }
+            close(fd[1]);
+            if (read(fd[0], &peaks[oneShot], sizeof(long)) != sizeof(long)) {
+                peaks[oneShot] = -1;
+            }
+            close(fd[0]);
+            waitpid(pid, nullptr, 0);
+        }
+        std::printf("%10zu %18ld %18ld\n", mb, peaks[0], peaks[1]);
+    }
+    std::printf("\n");
+}
+
+int main()
+{
+    streamingRss();
+
+    const size_t size = 1 << 20;
+    const int repeat = 3;
+
+    std::string text(size, 'A');
+    for (size_t i = 0; i < size; i++) {
+        text[i] = 'A' + i % 26;
+    }
+
+    // По умолчанию encrypt/decrypt не должны ничего писать в std::cout
+    countingBuffer counter;
+    std::streambuf* saved = std::cout.rdbuf(&counter);
+    {
+        routeCipher cipher(64);
+        cipher.decrypt(cipher.encrypt(text));
+    }
+    std::cout.rdbuf(saved);
+    std::printf("default path: %zu bytes written, %zu flushes\n\n", counter.bytes, counter.flushes);
+    if (counter.bytes != 0 || counter.flushes != 0) {
+        return 1;
+    }
+
+    nullBuffer null;
+    std::ostream null_stream(&null);
+    saved = std::cout.rdbuf(&null);
+
+    std::vector<double> table_mbs, traced_mbs, engine_mbs;
+    std::vector<int> keys;
+    for (int key = 2; key <= 4096; key *= 2) {
+        routeCipher cipher(key);
+        if (cipher.encrypt(text) != tableEncrypt(key, text)) {
+            std::cout.rdbuf(saved);
+            std::printf("mismatch for key %d\n", key);
+            return 1;
+        }
+        keys.push_back(key);
+        routeCipher traced(key, &null_stream);
+        table_mbs.push_back(throughput(size, repeat, [&] { tableEncrypt(key, text); }));
+        traced_mbs.push_back(throughput(size, repeat, [&] { traced.encrypt(text); }));
+        engine_mbs.push_back(throughput(size, repeat, [&] { cipher.encrypt(text); }));
+    }
+
+    std::cout.rdbuf(saved);
+    std::printf("%8s %14s %14s %14s %8s\n", "key", "table MB/s", "traced MB/s", "engine MB/s", "speedup");
+    for (size_t i = 0; i < keys.size(); i++) {
+        std::printf("%8d %14.1f %14.1f %14.1f %7.2fx\n", keys[i], table_mbs[i], traced_mbs[i],
+                    engine_mbs[i], engine_mbs[i] / table_mbs[i]);
+    }
+
+    // Плиточное ядро против обхода по столбцам: 100 МБ, ключи 64..65536
+    {
+        std::string huge;
+        huge.reserve(100 << 20);
+        while (huge.size() + text.size() <= (100 << 20)) {
+            huge += text;
+        }
+        std::printf("\ntiled, %zu MB\n%8s %14s %14s %8s\n", huge.size() >> 20,
+                    "key", "strided MB/s", "tiled MB/s", "speedup");
+        for (int key = 64; key <= 65536; key *= 4) {
+            routeCipher cipher(key);
+            if (cipher.encrypt(huge) != stridedEncrypt(key, huge)) {
+                std::printf("mismatch for key %d\n", key);
+                return 1;
+            }
+            double strided = throughput(huge.size(), 1, [&] { stridedEncrypt(key, huge); });
+            double tiled = throughput(huge.size(), 1, [&] { cipher.encrypt(huge); });
+            std::printf("%8d %14.1f %14.1f %7.2fx\n", key, strided, tiled, tiled / strided);
+        }
+    }
+
+    // Записи фиксированной длины: кэш перестановок против прямого обхода
+    {
+        permutationCache cache(64 << 20);
+        routeCipher direct(16);
+        routeCipher cached(16, nullptr, &cache);
+        std::string out(1 << 16, '\0');
+        std::printf("\nfixed-size records, key 16\n%8s %12s %12s %12s %12s\n", "bytes",
+                    "enc MB/s", "cached enc", "dec MB/s", "cached dec");
+        for (size_t bytes = 64; bytes <= 65536; bytes *= 4) {
+            std::string record = text.substr(0, bytes);
+            std::string encrypted = direct.encrypt(record);
+            int calls = static_cast<int>((256 << 20) / bytes);
+            double enc = throughput(bytes, calls, [&] { direct.encrypt(record, &out[0], out.size()); });
+            double encCached = throughput(bytes, calls, [&] { cached.encrypt(record, &out[0], out.size()); });
+            double dec = throughput(bytes, calls, [&] { direct.decrypt(encrypted, &out[0], out.size()); });
+            double decCached = throughput(bytes, calls, [&] { cached.decrypt(encrypted, &out[0], out.size()); });
+            std::printf("%8zu %12.1f %12.1f %12.1f %12.1f\n", bytes, enc, encCached, dec, decCached);
+        }
+        permutationCache::stats stats = cache.statistics();
+        std::printf("cache: %zu hits, %zu misses, %zu entries, %zu bytes\n",
+                    stats.hits, stats.misses, stats.entries, stats.bytes);
+    }
+
+    // Маршруты: все через скомпилированную перестановку из кэша против ядра по умолчанию
+    {
+        permutationCache cache(256 << 20);
+        std::printf("\nroutes, MB/s (enc / dec), cached permutation\n%-10s", "route");
+        size_t sizes[] = { 4096, 1 << 20 };
+        for (size_t bytes : sizes) {
+            std::printf(" %20zu", bytes);
+        }
+        std::printf("\n");
+        std::string keyword;
+        for (int i = 0; i < 64; i++) {
+            keyword.push_back('A' + (i * 11) % 26);
+        }
+        const char* names[] = { "default", "column", "snake", "spiral", "diagonal", "keyword" };
+        std::shared_ptr<const route> routes[] = {
+            nullptr, std::make_shared<columnRoute>(), std::make_shared<snakeRoute>(),
+            std::make_shared<spiralRoute>(), std::make_shared<diagonalRoute>(),
+            std::make_shared<keywordRoute>(keyword)
+        };
+        std::string out(1 << 20, '\0');
+        // Строки "own" - шифр без общего кэша, со своим (routeCacheBytes)
+        for (size_t row = 0; row < 11; row++) {
+            size_t r = (row + 1) / 2;
+            bool own = row % 2 == 0 && r != 0;
+            routeCipher cipher = !routes[r] ? routeCipher(64)
+                               : own ? routeCipher(64, routes[r])
+                               : routeCipher(64, routes[r], nullptr, &cache);
+            std::printf("%-10s", own ? "  own" : names[r]);
+            for (size_t bytes : sizes) {
+                std::string record = text.substr(0, bytes);
+                std::string encrypted = cipher.encrypt(record);
+                int calls = static_cast<int>((256 << 20) / bytes);
+                double enc = throughput(bytes, calls, [&] { cipher.encrypt(record, &out[0], out.size()); });
+                double dec = throughput(bytes, calls, [&] { cipher.decrypt(encrypted, &out[0], out.size()); });
+                std::printf(" %9.1f / %8.1f", enc, dec);
+            }
+            std::printf("\n");
+        }
+    }
+
+    // Многократная перестановка, 1 МБ: N последовательных проходов против
+    // одной композиции (сбор по готовой перестановке из кэша)
+    {
+        permutationCache cache(64 << 20);
+        const char* keywords[] = { "zebras", "striped", "cipher", "quantum" };
+        std::string record = text.substr(0, 1 << 20);
+        std::string out(record.size(), '\0'), step(record.size(), '\0');
+        std::printf("\n%-6s %16s %16s %10s\n", "passes", "chained MB/s", "composed MB/s", "ratio");
+        for (size_t passCount = 1; passCount <= 4; passCount++) {
+            std::vector<routeCipher> passes;
+            for (size_t i = 0; i < passCount; i++) {
+                std::string keyword = keywords[i];
+                passes.push_back(routeCipher(static_cast<int>(keyword.size()),
+                                             std::make_shared<keywordRoute>(keyword), nullptr, &cache));
+            }
+            routeChain chain(passes, &cache);
+            double chained = throughput(record.size(), 20, [&] {
+                passes[0].encrypt(record, &out[0], out.size());
+                for (size_t i = 1; i < passCount; i++) {
+                    out.swap(step);
+                    passes[i].encrypt(step, &out[0], out.size());
+                }
+            });
+            double composed = throughput(record.size(), 20, [&] { chain.encrypt(record, &out[0], out.size()); });
+            std::printf("%6zu %16.1f %16.1f %9.2fx\n", passCount, chained, composed, composed / chained);
+        }
+    }
+
+    // Доля некорректных открытых текстов 0%, 3%, 50%: исключения против tryEncrypt
+    {
+        const size_t messages = 200000;
+        routeCipher cipher(7);
+        std::printf("\n%-8s %14s %16s %10s\n", "invalid", "throw Mmsg/s", "noexcept Mmsg/s", "speedup");
+        for (unsigned percent : { 0u, 3u, 50u }) {
+            std::vector<std::string> inputs(messages);
+            for (size_t i = 0; i < messages; i++) {
+                inputs[i] = text.substr((i * 104729) % (text.size() - 120), 120);
+                if ((i * 7) % 100 < percent) {
+                    inputs[i][60] = '!';
+                }
+            }
+            size_t thrown = 0, returned = 0;
+            double viaThrow = throughput(messages, 1, [&] {
+                for (const auto& input : inputs) {
+                    try {
+                        cipher.encrypt(input);
+                    } catch (const cipher_error&) {
+                        thrown++;
+                    }
+                }
+            });
+            double viaResult = throughput(messages, 1, [&] {
+                for (const auto& input : inputs) {
+                    returned += !cipher.tryEncrypt(input);
+                }
+            });
+            if (thrown != returned) {
+                std::printf("error count mismatch\n");
+                return 1;
+            }
+            std::printf("%7u%% %14.2f %16.2f %9.2fx\n", percent, viaThrow, viaResult, viaResult / viaThrow);
+        }
+    }
+
+    // Масштабирование параллельного режима: 32 МБ, ключ 1024
+    std::string large;
+    for (int i = 0; i < 32; i++) {
+        large += text;
+    }
+    routeCipher wide(1024);
+    std::string encrypted = wide.encrypt(large);
+    std::printf("\nparallel, %zu MB, key 1024\n%8s %12s %12s %10s\n", large.size() >> 20,
+                "threads", "enc MB/s", "dec MB/s", "speedup");
+    double base = 0;
+    for (unsigned threads = 1; threads <= 32; threads *= 2) {
+        double enc = throughput(large.size(), 1, [&] { wide.encrypt(large, threads); });
+        double dec = throughput(encrypted.size(), 1, [&] { wide.decrypt(encrypted, threads); });
+        if (threads == 1) {
+            base = enc;
+        }
+        std::printf("%8u %12.1f %12.1f %9.2fx\n", threads, enc, dec, enc / base);
+    }
+    return 0;
+}
@@ -0,0 +1,28 @@
+// routeCipher_perf.cpp - Машинно-читаемые замеры routeCipher (JSON, см. perfSuite.h)
+#include "routeCipher.h"
+#include "perfSuite.h"
+#include "allocationCounter.h"
+#include <string>
+
+int main(int argc, char** argv)
+{
+    perfSuite suite("routeCipher", &allocations, argc, argv);
+    const int widths[] = { 4, 64, 1024 };
+
+    for (size_t bytes : suite.sizes()) {
+        std::string text(bytes, 'A');
+        for (size_t i = 0; i < bytes; i++) {
+            text[i] = 'A' + i % 26;
+        }
+        std::string out(bytes, '\0');
+        for (int key : widths) {
+            routeCipher cipher(key);
+            std::string encrypted = cipher.encrypt(text);
+            suite.run("encrypt", key, bytes, bytes, bytes, [&] { cipher.encrypt(text); });
+            suite.run("decrypt", key, bytes, bytes, bytes, [&] { cipher.decrypt(encrypted); });
+            suite.run("encrypt_into", key, bytes, bytes, bytes, [&] { cipher.encrypt(text, &out[0], out.size()); });
+            suite.run("decrypt_into", key, bytes, bytes, bytes, [&] { cipher.decrypt(encrypted, &out[0], out.size()); });
+        }
+    }
+    return suite.finish();
+}
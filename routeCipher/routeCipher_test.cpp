@@ -1,6 +1,11 @@
 // routeCipher_test.cpp - ИСПРАВЛЕННЫЙ
 #include "routeCipher.h"
+#include "allocationCounter.h"
+#include "sharedInstance.h"
 #include <UnitTest++/UnitTest++.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
 
 SUITE(ConstructorTest)
 {
@@ -275,6 +280,591 @@ SUITE(RoundTripTests)
     }
 }
 
+// Сверка с эталонной таблицей для всех сочетаний ключа и длины
+SUITE(ClosedFormTests)
+{
+    std::string tableEncrypt(int key, const std::string& text) {
+        size_t rows = (text.length() + key - 1) / key;
+        std::string result;
+        for (int j = key - 1; j >= 0; j--) {
+            for (size_t i = 0; i < rows; i++) {
+                size_t pos = i * key + j;
+                if (pos < text.length()) {
+                    result += text[pos];
+                }
+            }
+        }
+        return result;
+    }
+
+    TEST(MatchesTableForAllShapes) {
+        std::string alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        for (int key = 1; key <= 12; key++) {
+            routeCipher cipher(key);
+            for (size_t len = 1; len <= 40; len++) {
+                std::string text;
+                for (size_t i = 0; i < len; i++) {
+                    text += alphabet[i % alphabet.length()];
+                }
+                std::string encrypted = cipher.encrypt(text);
+                CHECK_EQUAL(tableEncrypt(key, text), encrypted);
+                CHECK_EQUAL(text, cipher.decrypt(encrypted));
+            }
+        }
+    }
+
+    TEST(TiledMatchesTable) {
+        // Ключи и длины, при которых работают плитки 8x8 и 16x16 с остатками
+        int keys[] = { 8, 9, 15, 16, 63, 64, 65, 130, 200 };
+        for (int key : keys) {
+            routeCipher cipher(key);
+            size_t lengths[] = { size_t(key) * 16, size_t(key) * 33 + 5, size_t(key) * 40 - 1 };
+            for (size_t len : lengths) {
+                std::string text;
+                for (size_t i = 0; i < len; i++) {
+                    text += char('A' + (i * 7 + i / 26) % 26);
+                }
+                std::string encrypted = cipher.encrypt(text);
+                CHECK_EQUAL(tableEncrypt(key, text), encrypted);
+                CHECK_EQUAL(text, cipher.decrypt(encrypted));
+                CHECK_EQUAL(encrypted, cipher.encrypt(text, 3));
+                CHECK_EQUAL(text, cipher.decrypt(encrypted, 3));
+            }
+        }
+    }
+}
+
+SUITE(TraceTest)
+{
+    TEST(NoOutputByDefault) {
+        std::ostringstream captured;
+        std::streambuf* saved = std::cout.rdbuf(captured.rdbuf());
+        routeCipher cipher(3);
+        cipher.decrypt(cipher.encrypt("ABCDEFGHIJ"));
+        std::cout.rdbuf(saved);
+        CHECK(captured.str().empty());
+    }
+
+    TEST(TableWrittenToSink) {
+        std::ostringstream trace;
+        routeCipher cipher(3, &trace);
+        cipher.encrypt("ABCDE");
+        CHECK_EQUAL("Encryption table:\nA B C \nD E   \n", trace.str());
+    }
+}
+
+SUITE(StreamTest)
+{
+    TEST(SingleSegmentEqualsOneShot) {
+        routeCipher cipher(4);
+        routeStream enc(cipher, routeStream::encryption, 100);
+        std::string encrypted = enc.update("Test string ");
+        encrypted += enc.update("here");
+        encrypted += enc.finish();
+        CHECK_EQUAL(cipher.encrypt("Test string here"), encrypted);
+    }
+
+    TEST(SegmentsAreIndependentBlocks) {
+        // key=3, 2 строки в сегменте: ABCDEF | GHIJ
+        routeCipher cipher(3);
+        routeStream enc(cipher, routeStream::encryption, 2);
+        std::string encrypted = enc.update("ABCDEFGHIJ");
+        encrypted += enc.finish();
+        CHECK_EQUAL(cipher.encrypt("ABCDEF") + cipher.encrypt("GHIJ"), encrypted);
+    }
+
+    TEST(RoundTripAnyChunking) {
+        std::string text;
+        for (int i = 0; i < 50; i++) {
+            text += "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG ";
+        }
+        std::string letters;
+        for (char c : text) {
+            if (c != ' ') {
+                letters += c;
+            }
+        }
+        for (int key = 1; key <= 9; key += 2) {
+            routeCipher cipher(key);
+            for (size_t rows = 1; rows <= 40; rows += 13) {
+                for (size_t chunk = 1; chunk <= 700; chunk += 233) {
+                    routeStream enc(cipher, routeStream::encryption, rows);
+                    std::string encrypted;
+                    for (size_t pos = 0; pos < text.size(); pos += chunk) {
+                        enc.update(text.data() + pos, std::min(chunk, text.size() - pos), encrypted);
+                    }
+                    enc.finish(encrypted);
+
+                    routeStream dec(cipher, routeStream::decryption, rows);
+                    std::string decrypted;
+                    for (size_t pos = 0; pos < encrypted.size(); pos += chunk) {
+                        dec.update(encrypted.data() + pos, std::min(chunk, encrypted.size() - pos), decrypted);
+                    }
+                    dec.finish(decrypted);
+                    CHECK_EQUAL(letters, decrypted);
+                }
+            }
+        }
+    }
+
+    TEST(StreamValidation) {
+        routeCipher cipher(3);
+        routeStream enc(cipher, routeStream::encryption, 4);
+        CHECK_THROW(enc.update("ABC1"), cipher_error);
+        routeStream empty(cipher, routeStream::encryption, 4);
+        empty.update("   ");
+        CHECK_THROW(empty.finish(), cipher_error);
+        routeStream dec(cipher, routeStream::decryption, 4);
+        CHECK_THROW(dec.update("AB C"), cipher_error);
+        CHECK_THROW(routeStream(cipher, routeStream::encryption, 0), cipher_error);
+    }
+
+    TEST(HugeKeyAllocatesByText) {
+        routeCipher cipher(2000000000);
+        routeStream enc(cipher, routeStream::encryption, 4);
+        std::string encrypted = enc.update("Hel");
+        encrypted += enc.update("lo");
+        encrypted += enc.finish();
+        CHECK_EQUAL("OLLEH", encrypted);
+        CHECK_THROW(routeStream(cipher, routeStream::encryption, size_t(-1) / 2), cipher_error);
+    }
+
+    TEST(FailedUpdateLeavesStreamUnchanged) {
+        // Ошибка в конце куска, который успел бы сбросить сегмент
+        routeCipher cipher(3);
+        routeStream enc(cipher, routeStream::encryption, 2);
+        std::string encrypted = enc.update("ABCD");
+        std::string before = encrypted;
+        CHECK_THROW(enc.update("EFGHIJ1", 7, encrypted), cipher_error);
+        CHECK_EQUAL(before, encrypted);
+        encrypted += enc.update("EFGHIJ");
+        encrypted += enc.finish();
+        CHECK_EQUAL(cipher.encrypt("ABCDEF") + cipher.encrypt("GHIJ"), encrypted);
+    }
+}
+
+SUITE(ParallelTest)
+{
+    TEST(ParallelEqualsSerial) {
+        std::string text;
+        for (int i = 0; i < 10000; i++) {
+            text += "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG";
+        }
+        int keys[] = { 1, 2, 7, 64, 1000, 400000 };
+        unsigned counts[] = { 0, 2, 3, 8 };
+        for (int key : keys) {
+            routeCipher cipher(key);
+            std::string encrypted = cipher.encrypt(text);
+            for (unsigned threads : counts) {
+                CHECK_EQUAL(encrypted, cipher.encrypt(text, threads));
+                CHECK_EQUAL(text, cipher.decrypt(encrypted, threads));
+            }
+        }
+    }
+
+    TEST(SharedInstance) {
+        // Один экземпляр из нескольких потоков: тексты с пробелами разной длины
+        const routeCipher cipher(7);
+        std::vector<std::string> texts;
+        for (int t = 0; t < 4; t++) {
+            std::string text;
+            for (int i = 0; i < 2000 * (t + 1); i++) {
+                text += i % 5 ? static_cast<char>('a' + (i * (t + 3)) % 26) : ' ';
+            }
+            texts.push_back(text);
+        }
+        std::vector<std::string> expected;
+        for (const auto& text : texts) {
+            expected.push_back(cipher.encrypt(text));
+        }
+        CHECK_EQUAL(0u, sharedInstanceMismatches(texts.size(), 50, [&](size_t t) {
+            std::string out(texts[t].size(), '\0');
+            size_t length = cipher.encrypt(texts[t], &out[0], out.size());
+            return out.compare(0, length, expected[t]) == 0;
+        }));
+    }
+
+    TEST(ParallelValidation) {
+        routeCipher cipher(3);
+        CHECK_THROW(cipher.encrypt("123", 4), cipher_error);
+        CHECK_THROW(cipher.decrypt("AB C", 4), cipher_error);
+    }
+}
+
+SUITE(NoThrowTest)
+{
+    TEST(ResultMatchesThrowingApi) {
+        routeCipher cipher(4);
+        const char* texts[] = { "Test string here", "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG", "a" };
+        for (const char* text : texts) {
+            routeCipher::result encrypted = cipher.tryEncrypt(text);
+            CHECK(encrypted);
+            CHECK_EQUAL(cipher.encrypt(text), encrypted.value);
+            routeCipher::result decrypted = cipher.tryDecrypt(encrypted.value);
+            CHECK(decrypted);
+            CHECK_EQUAL(cipher.decrypt(encrypted.value), decrypted.value);
+        }
+    }
+
+    TEST(ErrorCodes) {
+        routeCipher cipher(3);
+        CHECK_EQUAL(routeCipher::emptyText, cipher.tryEncrypt("").error);
+        CHECK_EQUAL(routeCipher::noLetters, cipher.tryEncrypt("    ").error);
+        routeCipher::result bad = cipher.tryEncrypt("Hello, World");
+        CHECK(!bad);
+        CHECK_EQUAL(routeCipher::invalidCharacter, bad.error);
+        CHECK_EQUAL(5u, bad.position);
+        CHECK(bad.value.empty());
+        CHECK_EQUAL(routeCipher::emptyText, cipher.tryDecrypt("").error);
+        CHECK_EQUAL(routeCipher::invalidCharacter, cipher.tryDecrypt("AB C").error);
+        CHECK_EQUAL(2u, cipher.tryDecrypt("AB C").position);
+        CHECK(!routeCipher::validateKey(0));
+        CHECK(!routeCipher::validateKey(-5));
+        CHECK(routeCipher::validateKey(1));
+    }
+
+    TEST(ThrowingTraceStream) {
+        // Буфер без места: любая запись ставит badbit, а поток бросает исключение
+        struct fullBuffer : std::streambuf {};
+        fullBuffer buffer;
+        std::ostream trace(&buffer);
+        trace.exceptions(std::ios::badbit);
+        routeCipher cipher(4, &trace);
+        routeCipher::result encrypted = cipher.tryEncrypt("Test string here");
+        CHECK(encrypted);
+        CHECK_EQUAL(routeCipher(4).encrypt("Test string here"), encrypted.value);
+        routeCipher::result decrypted = cipher.tryDecrypt(encrypted.value);
+        CHECK(decrypted);
+        CHECK_EQUAL("TESTSTRINGHERE", decrypted.value);
+    }
+
+    TEST(PositionInEveryBlockLane) {
+        // Позиции по обе стороны границ 16-байтовых блоков и в хвосте
+        for (size_t n = 1; n <= 70; n++) {
+            for (size_t bad = 0; bad < n; bad++) {
+                std::string text(n, 'q');
+                text[bad] = bad % 2 ? '{' : '@';
+                routeCipher::validation status = routeCipher::validateCipherText(text.data(), n);
+                CHECK_EQUAL(routeCipher::invalidCharacter, status.error);
+                CHECK_EQUAL(bad, status.position);
+                text[bad] = ' ';
+                CHECK_EQUAL(bad, routeCipher::validateCipherText(text.data(), n).position);
+                CHECK_EQUAL(n > 1 ? routeCipher::ok : routeCipher::noLetters,
+                            routeCipher::validateOpenText(text.data(), n).error);
+            }
+        }
+    }
+
+    TEST(NonAsciiBytesRejected) {
+        std::string text = "ABCDEFGHIJKLMNOPQRST";
+        text[17] = '\xC1';
+        CHECK_EQUAL(17u, routeCipher::validateOpenText(text.data(), text.size()).position);
+    }
+}
+
+SUITE(BufferTest)
+{
+    TEST(BufferMatchesString) {
+        routeCipher cipher(4);
+        const char* texts[] = { "Test string here", "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG", "a b" };
+        for (std::string text : texts) {
+            std::string out(text.size(), '\0');
+            size_t length = cipher.encrypt(text, &out[0], out.size());
+            CHECK_EQUAL(cipher.encrypt(text), out.substr(0, length));
+            std::string encrypted = out.substr(0, length);
+            length = cipher.decrypt(encrypted, &out[0], out.size());
+            CHECK_EQUAL(cipher.decrypt(encrypted), out.substr(0, length));
+        }
+    }
+
+    TEST(CapacityChecked) {
+        routeCipher cipher(3);
+        char out[8];
+        CHECK_EQUAL(8u, cipher.encrypt("ab cd ef gh", out, 8));
+        CHECK_THROW(cipher.encrypt("abcdefghi", out, 8), cipher_error);
+        CHECK_THROW(cipher.decrypt("ABCDEFGHI", out, 8), cipher_error);
+        CHECK_THROW(cipher.encrypt("ab!", out, 8), cipher_error);
+    }
+
+    TEST(NoAllocationsAfterWarmUp) {
+        routeCipher cipher(7);
+        std::string spaced = "The quick brown fox jumps over the lazy dog";
+        std::string solid = "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG";
+        std::string out(spaced.size(), '\0');
+        std::string encrypted;
+        encrypted.reserve(spaced.size());
+        cipher.encrypt(spaced, &out[0], out.size());
+
+        allocations = 0;
+        for (int i = 0; i < 100; i++) {
+            size_t length = cipher.encrypt(spaced, &out[0], out.size());
+            encrypted.assign(out, 0, length);
+            cipher.decrypt(encrypted, &out[0], out.size());
+            length = cipher.encrypt(solid, &out[0], out.size());
+            encrypted.assign(out, 0, length);
+            cipher.decrypt(encrypted, &out[0], out.size());
+        }
+        CHECK_EQUAL(0u, allocations);
+        // Счётчик работает: возврат новой строки выделяет память
+        cipher.encrypt(spaced);
+        CHECK(allocations > 0);
+    }
+}
+
+SUITE(CacheTest)
+{
+    TEST(CachedMatchesDirect) {
+        permutationCache cache(1 << 20);
+        std::string text;
+        for (int i = 0; i < 3000; i++) {
+            text.push_back('A' + i % 26);
+        }
+        int keys[] = { 1, 2, 3, 7, 8, 64, 100, 5000 };
+        size_t lengths[] = { 1, 2, 7, 64, 65, 999, 3000 };
+        for (int key : keys) {
+            routeCipher direct(key);
+            routeCipher cached(key, nullptr, &cache);
+            for (size_t n : lengths) {
+                std::string part = text.substr(0, n);
+                std::string encrypted = direct.encrypt(part);
+                CHECK_EQUAL(encrypted, cached.encrypt(part));
+                CHECK_EQUAL(encrypted, cached.encrypt(part));
+                CHECK_EQUAL(part, cached.decrypt(encrypted));
+            }
+        }
+    }
+
+    TEST(WideIndices) {
+        permutationCache cache(1 << 20);
+        std::string text(70000, 'A');
+        for (size_t i = 0; i < text.size(); i++) {
+            text[i] = 'A' + i % 23;
+        }
+        routeCipher direct(37);
+        routeCipher cached(37, nullptr, &cache);
+        std::string encrypted = direct.encrypt(text);
+        CHECK_EQUAL(encrypted, cached.encrypt(text));
+        CHECK_EQUAL(text, cached.decrypt(encrypted));
+        CHECK_EQUAL(2 * 70000u * 4, cache.statistics().bytes);
+    }
+
+    TEST(LengthBeyondWideIndices) {
+        // Позиции до maxLength - 1 помещаются в 32 бита, дальше - исключение до выделения памяти
+        CHECK_EQUAL(size_t(UINT32_MAX), routePermutation::maxLength - 1);
+        CHECK_THROW(routePermutation(routePermutation::maxLength + 1), cipher_error);
+    }
+
+    TEST(HitsMissesAndEviction) {
+        // Ёмкость - две перестановки по ~100 символов (16-битные индексы в обе стороны)
+        permutationCache cache(900);
+        routeCipher cipher(4, nullptr, &cache);
+        std::string a(100, 'A'), b(100, 'B'), c(100, 'C');
+        cipher.encrypt(a);
+        cipher.decrypt(a);
+        cipher.encrypt(b + "B");
+        permutationCache::stats stats = cache.statistics();
+        CHECK_EQUAL(1u, stats.hits);
+        CHECK_EQUAL(2u, stats.misses);
+        CHECK_EQUAL(0u, stats.evictions);
+        CHECK_EQUAL(2u, stats.entries);
+        CHECK_EQUAL(804u, stats.bytes);
+        // Длина 100 использовалась позже, вытесняется 101
+        cipher.encrypt(a);
+        cipher.encrypt(c + "CC");
+        stats = cache.statistics();
+        CHECK_EQUAL(1u, stats.evictions);
+        CHECK_EQUAL(2u, stats.entries);
+        cipher.encrypt(a);
+        CHECK_EQUAL(3u, cache.statistics().hits);
+        // Перестановка больше ёмкости строится, но не сохраняется
+        cipher.encrypt(std::string(300, 'D'));
+        cipher.encrypt(std::string(300, 'D'));
+        stats = cache.statistics();
+        CHECK_EQUAL(5u, stats.misses);
+        CHECK_EQUAL(2u, stats.entries);
+        cache.clear();
+        CHECK_EQUAL(0u, cache.statistics().bytes);
+    }
+
+    TEST(SharedBetweenKeys) {
+        permutationCache cache(1 << 16);
+        routeCipher three(3, nullptr, &cache);
+        routeCipher four(4, nullptr, &cache);
+        CHECK_EQUAL(routeCipher(3).encrypt("ABCDEFGHIJ"), three.encrypt("ABCDEFGHIJ"));
+        CHECK_EQUAL(routeCipher(4).encrypt("ABCDEFGHIJ"), four.encrypt("ABCDEFGHIJ"));
+        CHECK_EQUAL(2u, cache.statistics().misses);
+    }
+
+    TEST(NoAllocationsOnHit) {
+        permutationCache cache(1 << 16);
+        routeCipher cipher(9, nullptr, &cache);
+        std::string text = "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG";
+        std::string out(text.size(), '\0');
+        cipher.encrypt(text, &out[0], out.size());
+        allocations = 0;
+        for (int i = 0; i < 100; i++) {
+            cipher.encrypt(text, &out[0], out.size());
+        }
+        CHECK_EQUAL(0u, allocations);
+    }
+}
+
+SUITE(RouteTest)
+{
+    TEST(KnownTables) {
+        // A B C D / E F G H / I J
+        CHECK_EQUAL("DHGCBFJIEA", routeCipher(4, std::make_shared<snakeRoute>()).encrypt("ABCDEFGHIJ"));
+        CHECK_EQUAL("ABCDHJIEFG", routeCipher(4, std::make_shared<spiralRoute>()).encrypt("ABCDEFGHIJ"));
+        CHECK_EQUAL("ABECFIDGJH", routeCipher(4, std::make_shared<diagonalRoute>()).encrypt("ABCDEFGHIJ"));
+        // A B C / D E F / G H I / J, столбцы в порядке букв слова CAB: 1, 2, 0
+        CHECK_EQUAL("BEHCFIADGJ", routeCipher(3, std::make_shared<keywordRoute>("cab")).encrypt("ABCDEFGHIJ"));
+    }
+
+    TEST(ColumnRouteMatchesDefault) {
+        std::string text = "THEQUICKBROWNFOXJUMPSOVERTHELAZYDOG";
+        for (int key = 1; key <= 40; key++) {
+            CHECK_EQUAL(routeCipher(key).encrypt(text),
+                        routeCipher(key, std::make_shared<columnRoute>()).encrypt(text));
+        }
+    }
+
+    TEST(RoundTripEveryRoute) {
+        std::string text;
+        for (int i = 0; i < 500; i++) {
+            text.push_back('A' + (i * 7) % 26);
+        }
+        permutationCache cache(1 << 20);
+        int keys[] = { 1, 2, 3, 5, 8, 17, 64 };
+        size_t lengths[] = { 1, 2, 3, 7, 16, 63, 64, 65, 500 };
+        for (int key : keys) {
+            std::string keyword;
+            for (int i = 0; i < key; i++) {
+                keyword.push_back('A' + (i * 11) % 26);
+            }
+            std::shared_ptr<const route> routes[] = {
+                std::make_shared<columnRoute>(), std::make_shared<snakeRoute>(),
+                std::make_shared<spiralRoute>(), std::make_shared<diagonalRoute>(),
+                std::make_shared<keywordRoute>(keyword)
+            };
+            for (const auto& path : routes) {
+                routeCipher cipher(key, path);
+                routeCipher cached(key, path, nullptr, &cache);
+                for (size_t n : lengths) {
+                    std::string part = text.substr(0, n);
+                    std::string encrypted = cipher.encrypt(part);
+                    std::string sortedIn = part, sortedOut = encrypted;
+                    std::sort(sortedIn.begin(), sortedIn.end());
+                    std::sort(sortedOut.begin(), sortedOut.end());
+                    CHECK_EQUAL(sortedIn, sortedOut);
+                    CHECK_EQUAL(part, cipher.decrypt(encrypted));
+                    CHECK_EQUAL(encrypted, cached.encrypt(part));
+                    CHECK_EQUAL(part, cached.decrypt(encrypted));
+                }
+            }
+        }
+    }
+
+    TEST(ParallelAndStream) {
+        std::string text;
+        for (int i = 0; i < 300000; i++) {
+            text.push_back('A' + i % 26);
+        }
+        routeCipher cipher(1000, std::make_shared<spiralRoute>());
+        std::string encrypted = cipher.encrypt(text);
+        CHECK_EQUAL(encrypted, cipher.encrypt(text, 4));
+        CHECK_EQUAL(text, cipher.decrypt(encrypted, 4));
+
+        routeStream enc(routeCipher(5, std::make_shared<snakeRoute>()), routeStream::encryption, 3);
+        std::string streamed = enc.update(text.substr(0, 15));
+        streamed += enc.finish();
+        CHECK_EQUAL(routeCipher(5, std::make_shared<snakeRoute>()).encrypt(text.substr(0, 15)), streamed);
+    }
+
+    // Змейка, которая считает свои обходы
+    struct countingRoute : snakeRoute {
+        mutable int walks = 0;
+        void walk(size_t rows, size_t columns, const visitor& visit) const override
+        {
+            walks++;
+            snakeRoute::walk(rows, columns, visit);
+        }
+    };
+
+    TEST(UncachedRouteWalksOncePerLength) {
+        auto path = std::make_shared<countingRoute>();
+        routeCipher cipher(4, path);
+        std::string encrypted = cipher.encrypt("ABCDEFGHIJ");
+        cipher.encrypt("ABCDEFGHIJ");
+        CHECK_EQUAL("ABCDEFGHIJ", cipher.decrypt(encrypted));
+        CHECK_EQUAL(1, path->walks);
+        cipher.encrypt("ABCDEFG");
+        CHECK_EQUAL(2, path->walks);
+        // Копии шифра делят его кэш
+        routeCipher copy = cipher;
+        copy.encrypt("ABCDEFG");
+        CHECK_EQUAL(2, path->walks);
+    }
+
+    TEST(RouteErrors) {
+        CHECK_THROW(routeCipher(4, std::make_shared<keywordRoute>("cab")), cipher_error);
+        CHECK_THROW(keywordRoute(""), cipher_error);
+        CHECK_THROW(keywordRoute("ca b"), cipher_error);
+        CHECK_THROW(routeCipher(3, std::shared_ptr<const route>()), cipher_error);
+    }
+}
+
+SUITE(ChainTest)
+{
+    TEST(DoubleTranspositionMatchesSequentialPasses) {
+        std::string text = "WE ARE DISCOVERED FLEE AT ONCE";
+        routeCipher first(6, std::make_shared<keywordRoute>("zebras"));
+        routeCipher second(7, std::make_shared<keywordRoute>("striped"));
+        routeChain chain({ first, second });
+        std::string expected = second.encrypt(first.encrypt(text));
+        CHECK_EQUAL(expected, chain.encrypt(text));
+        CHECK_EQUAL("WEAREDISCOVEREDFLEEATONCE", chain.decrypt(expected));
+    }
+
+    TEST(ManyPassesRoundTrip) {
+        std::string text;
+        for (int i = 0; i < 1000; i++) {
+            text.push_back('a' + (i * 5) % 26);
+        }
+        permutationCache cache(1 << 20);
+        std::vector<routeCipher> passes = {
+            routeCipher(6, std::make_shared<keywordRoute>("cipher")), routeCipher(13),
+            routeCipher(5, std::make_shared<spiralRoute>()), routeCipher(4, std::make_shared<keywordRoute>("bdac"))
+        };
+        routeChain chain(passes, &cache);
+        size_t lengths[] = { 1, 2, 3, 17, 64, 1000 };
+        for (size_t n : lengths) {
+            std::string part = text.substr(0, n);
+            std::string expected = part;
+            for (auto& pass : passes) {
+                expected = pass.encrypt(expected);
+            }
+            CHECK_EQUAL(expected, chain.encrypt(part));
+            std::string upper = part;
+            for (auto& c : upper) {
+                c &= ~0x20;
+            }
+            CHECK_EQUAL(upper, chain.decrypt(expected));
+        }
+        chain.encrypt(text);
+        CHECK_EQUAL(6u, cache.statistics().misses);
+        CHECK_EQUAL(7u, cache.statistics().hits);
+    }
+
+    TEST(ChainErrors) {
+        CHECK_THROW(routeChain(std::vector<routeCipher>()), cipher_error);
+        routeChain chain({ routeCipher(3) });
+        CHECK_THROW(chain.encrypt("AB1"), cipher_error);
+        CHECK_THROW(chain.decrypt(""), cipher_error);
+        char out[2];
+        CHECK_THROW(chain.encrypt("ABC", out, sizeof out), cipher_error);
+    }
+}
+
 // Валидационные тесты
 SUITE(ValidationTest)
 {
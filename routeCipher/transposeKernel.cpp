@@ -0,0 +1,92 @@
+#include "transposeKernel.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+size_t transposeTileSize(size_t key)
+{
+    if (key < 8) {
+        return 0;
+    }
+    return key < 64 ? 8 : 16;
+}
+
+static void transposeScalar(const char* const* src, char* const* dst, size_t size)
+{
+    for (size_t r = 0; r < size; r++) {
+        for (size_t c = 0; c < size; c++) {
+            dst[c][r] = src[r][c];
+        }
+    }
+}
+
+#ifdef __SSE2__
+// Четыре ступени распаковки: байты, слова, двойные слова, учетверённые слова
+static void transpose16(const char* const* src, char* const* dst)
+{
+    __m128i a[16], b[16];
+    for (int r = 0; r < 16; r++) {
+        a[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src[r]));
+    }
+    for (int r = 0; r < 8; r++) {
+        b[r] = _mm_unpacklo_epi8(a[2 * r], a[2 * r + 1]);
+        b[r + 8] = _mm_unpackhi_epi8(a[2 * r], a[2 * r + 1]);
+    }
+    for (int r = 0; r < 8; r++) {
+        a[r] = _mm_unpacklo_epi16(b[2 * r], b[2 * r + 1]);
+        a[r + 8] = _mm_unpackhi_epi16(b[2 * r], b[2 * r + 1]);
+    }
+    for (int r = 0; r < 8; r++) {
+        b[r] = _mm_unpacklo_epi32(a[2 * r], a[2 * r + 1]);
+        b[r + 8] = _mm_unpackhi_epi32(a[2 * r], a[2 * r + 1]);
+    }
+    for (int r = 0; r < 8; r++) {
+        a[r] = _mm_unpacklo_epi64(b[2 * r], b[2 * r + 1]);
+        a[r + 8] = _mm_unpackhi_epi64(b[2 * r], b[2 * r + 1]);
+    }
+    // После четырёх ступеней столбец c оказывается в a[perm[c]]
+    static const int perm[16] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
+    for (int c = 0; c < 16; c++) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst[c]), a[perm[c]]);
+    }
+}
+
+static void transpose8(const char* const* src, char* const* dst)
+{
+    __m128i a[8], b[4];
+    for (int r = 0; r < 8; r++) {
+        a[r] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src[r]));
+    }
+    for (int r = 0; r < 4; r++) {
+        b[r] = _mm_unpacklo_epi8(a[2 * r], a[2 * r + 1]);
+    }
+    for (int r = 0; r < 2; r++) {
+        a[r] = _mm_unpacklo_epi16(b[2 * r], b[2 * r + 1]);
+        a[r + 2] = _mm_unpackhi_epi16(b[2 * r], b[2 * r + 1]);
+    }
+    b[0] = _mm_unpacklo_epi32(a[0], a[1]);
+    b[1] = _mm_unpackhi_epi32(a[0], a[1]);
+    b[2] = _mm_unpacklo_epi32(a[2], a[3]);
+    b[3] = _mm_unpackhi_epi32(a[2], a[3]);
+    for (int c = 0; c < 4; c++) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[2 * c]), b[c]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst[2 * c + 1]), _mm_unpackhi_epi64(b[c], b[c]));
+    }
+}
+#endif
+
+void transposeTile(const char* const* src, char* const* dst, size_t size)
+{
+#ifdef __SSE2__
+    if (size == 16) {
+        transpose16(src, dst);
+        return;
+    }
+    if (size == 8) {
+        transpose8(src, dst);
+        return;
+    }
+#endif
+    transposeScalar(src, dst, size);
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <cstddef>
+
+// Сторона квадратной плитки транспонирования для таблицы в key столбцов:
+// 0 - плитки не нужны (короткие строки и так лежат в одной строке кэша), иначе 8 или 16
+size_t transposeTileSize(size_t key);
+
+// Транспонирует плитку size x size байт (size = 8 или 16): байт c строки src[r]
+// записывается байтом r в строку dst[c]. На x86 - перестановки SSE2 в регистрах.
+void transposeTile(const char* const* src, char* const* dst, size_t size);